@@ -9,7 +9,10 @@
     License. See LICENSE.TXT for details.
 */
 
+#include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <type_traits>
 
 #include "triSYCL/access.hpp"
@@ -107,9 +110,10 @@ class accessor
       target_buffer.implementation->implementation, command_group_handler }
   } {
     static_assert(Target == access::target::global_buffer
-                  || Target == access::target::constant_buffer,
-                  "access target should be global_buffer or constant_buffer "
-                  "when a handler is used");
+                  || Target == access::target::constant_buffer
+                  || Target == access::target::host_task,
+                  "access target should be global_buffer, constant_buffer "
+                  "or host_task when a handler is used");
     // Now the implementation is created, register it
     implementation->register_accessor();
   }
@@ -141,6 +145,13 @@ class accessor
       offset+range[ for every dimension. Any other parts of the buffer
       will be unaffected.
 
+      The accessor is still indexed with the ids of the whole buffer,
+      as in SYCL 1.2.1, but only the accessed region is taken into
+      account for the dependencies between kernels, so that kernels
+      working on disjoint regions of the same buffer can run
+      concurrently. Accessing an element outside of the region is
+      undefined behavior.
+
       Constructor only available for access modes global_buffer, and
       constant_buffer (see Table "Buffer accessor constructors").
       access_target defines the form of access being obtained.
@@ -152,9 +163,18 @@ class accessor
   template <typename Allocator>
   accessor(buffer<DataType, Dimensions, Allocator> &target_buffer,
            handler &command_group_handler,
-           const range<Dimensions> &offset,
-           const range<Dimensions> &range) {
-    TRISYCL_UNIMPL;
+           const range<Dimensions> &access_range,
+           const id<Dimensions> &access_offset = {}) : implementation_t {
+    new detail::accessor<DataType, Dimensions, AccessMode, Target> {
+      target_buffer.implementation->implementation, command_group_handler,
+      access_range, access_offset }
+  } {
+    static_assert(Target == access::target::global_buffer
+                  || Target == access::target::constant_buffer
+                  || Target == access::target::host_task,
+                  "access target should be global_buffer, constant_buffer "
+                  "or host_task when a handler is used");
+    implementation->register_accessor();
   }
 
 
@@ -227,6 +247,13 @@ class accessor
     return implementation->get_size();
   }
 
+
+  /** Return the id of the first element accessed, which is 0 unless
+      the accessor was constructed with an access offset */
+  auto get_offset() const {
+    return implementation->get_offset();
+  }
+
   /** Use the accessor with integers à la [i1][i2][i3] or C++23 [i1, i2,...]
 
       \return decltype(auto) to return either a reference to the final
@@ -319,6 +346,26 @@ class accessor
     return implementation->get_pointer();
   }
 
+
+  /** Get the pointer to the start of the data, telling the compiler
+      that it is aligned on \p Alignment bytes
+
+      The buffer has to be created with a \c
+      property::buffer::alignment of at least \p Alignment. This
+      excludes the sub-buffers, whose offset in their parent buffer
+      may break the alignment, which is only checked in debug mode.
+
+      This is a triSYCL extension.
+  */
+  template <std::size_t Alignment>
+  auto
+  get_aligned_pointer() const {
+    auto p = get_pointer();
+    assert(reinterpret_cast<std::uintptr_t>(p) % Alignment == 0
+           && "The accessed data are not aligned as requested");
+    return std::assume_aligned<Alignment>(p);
+  }
+
   /** Forward all the iterator functions to the implementation
 
       \todo Add these functions to the specification
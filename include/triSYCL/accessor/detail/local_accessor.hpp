@@ -58,6 +58,7 @@ class accessor<T, Dimensions, Mode, access::target::local>
            handler& command_group_handler)
       : buf { std::make_shared<buffer<T, Dimensions>>(allocation_size) } {
     this->set_buffer(buf);
+    buf->allocate_on_host();
     this->set_access(buf->access);
   }
 };
@@ -11,6 +11,8 @@
 
 #include <concepts>
 #include <cstddef>
+#include <cstdint>
+#include <filesystem>
 #include <iterator>
 #include <memory>
 #include <ranges>
@@ -21,11 +23,15 @@
 #include "triSYCL/buffer/detail/buffer.hpp"
 #include "triSYCL/buffer/detail/buffer_waiter.hpp"
 #include "triSYCL/buffer_allocator.hpp"
+#include "triSYCL/detail/aligned_allocator.hpp"
+#include "triSYCL/detail/any_allocator.hpp"
+#include "triSYCL/detail/file_mapping.hpp"
 #include "triSYCL/detail/global_config.hpp"
 #include "triSYCL/detail/shared_ptr_implementation.hpp"
 #include "triSYCL/event.hpp"
 #include "triSYCL/handler.hpp"
 #include "triSYCL/id.hpp"
+#include "triSYCL/property_list.hpp"
 #include "triSYCL/queue.hpp"
 #include "triSYCL/range.hpp"
 
@@ -35,14 +41,28 @@ namespace trisycl {
     @{
 */
 
+/** An open file to create a buffer backed by this file mapped in
+    memory
+
+    It is a distinct type so that a buffer is not created from a file
+    by accident from a list of integers.
+
+    This is a triSYCL extension.
+*/
+struct file_descriptor {
+  /// The POSIX file descriptor
+  int fd;
+
+  explicit file_descriptor(int fd) : fd { fd } {}
+};
+
+
 /** A SYCL buffer is a multidimensional variable length array (à la C99
     VLA or even Fortran before) that is used to store data to work on.
 
     \todo There is a naming inconsistency in the specification between
     buffer and accessor on T versus datatype
 
-    \todo Finish allocator implementation
-
     \todo Think about the need of an allocator when constructing a buffer
     from other buffers
 
@@ -61,9 +81,12 @@ template <typename T,
              need an allocator of non const T */
           typename Allocator = buffer_allocator<std::remove_const_t<T>>>
 class buffer
+  /* The properties come first since they are used to create the
+     implementation */
+  : public property_list,
   /* Use the underlying buffer waiter implementation that can be
      shared in the SYCL model */
-  : public detail::shared_ptr_implementation<
+    public detail::shared_ptr_implementation<
                          buffer<T, Dimensions, Allocator>,
                          detail::buffer_waiter<T, Dimensions, Allocator>>,
     detail::debug<buffer<T, Dimensions, Allocator>> {
@@ -116,13 +139,31 @@ public:
       \param[in] r defines the size
 
       \param[in] allocator is to be used by the SYCL runtime
+
+      \param[in] propList are the properties of the buffer
   */
-  buffer(const range<Dimensions> &r, Allocator allocator = {})
-    : implementation_t { detail::waiter<T, Dimensions, Allocator>(
-                         new detail::buffer<T, Dimensions> { r }) }
+  buffer(const range<Dimensions> &r,
+         Allocator allocator = {},
+         const property_list &propList = {})
+    : property_list { propList }
+    , implementation_t { detail::waiter<T, Dimensions, Allocator>(
+                         new detail::buffer<T, Dimensions>
+                         { r, storage_allocator(allocator) },
+                         is_detached()) }
       {}
 
 
+  /** Create a new buffer of the given size with storage managed by
+      the SYCL runtime, using the default allocator
+
+      \param[in] r defines the size
+
+      \param[in] propList are the properties of the buffer
+  */
+  buffer(const range<Dimensions> &r, const property_list &propList)
+    : buffer { r, Allocator {}, propList } {}
+
+
   /** Create a new buffer with associated host memory
 
       \param[in] host_data points to the storage and values used by
@@ -142,6 +183,8 @@ public:
       no write after its destruction, unless there is another final
       data address given after construction of the buffer.
 
+      \param[in] propList are the properties of the buffer
+
       Only enable this constructor if it is not the same as the one
       with \code const T *host_data \endcode, which is when \c T is
       already a constant type.
@@ -152,10 +195,32 @@ public:
             typename = std::enable_if_t<!std::is_const<Dependent>::value>>
   buffer(const T *host_data,
          const range<Dimensions> &r,
-         Allocator allocator = {})
-    : implementation_t { detail::waiter(new detail::buffer<T, Dimensions>
-                         { host_data, r }) }
-  {}
+         Allocator allocator = {},
+         const property_list &propList = {})
+    : property_list { propList }
+    , implementation_t { detail::waiter<T, Dimensions, Allocator>(
+                         new detail::buffer<T, Dimensions>
+                         { host_data, r, storage_allocator(allocator) },
+                         is_detached()) } {
+    check_alignment(host_data);
+  }
+
+
+  /** Create a new buffer initialized from read-only host memory,
+      using the default allocator
+
+      \param[in] host_data points to the values used by the buffer
+
+      \param[in] r defines the size
+
+      \param[in] propList are the properties of the buffer
+  */
+  template <typename Dependent = T,
+            typename = std::enable_if_t<!std::is_const<Dependent>::value>>
+  buffer(const T *host_data,
+         const range<Dimensions> &r,
+         const property_list &propList)
+    : buffer { host_data, r, Allocator {}, propList } {}
 
 
   /** Create a new buffer with associated host memory
@@ -173,13 +238,38 @@ public:
       overrides the behavior using the set_final_data method. host_data
       points to the storage and values used by the buffer and
       range<Dimensions> defines the size.
+
+      With the \c property::buffer::detach_on_destroy property, the
+      host memory is only up-to-date once the event returned by \c
+      get_write_back_event() is complete.
   */
   buffer(T *host_data,
          const range<Dimensions> &r,
-         Allocator allocator = {})
-    : implementation_t { detail::waiter(new detail::buffer<T, Dimensions>
-                         { host_data, r }) }
-  {}
+         Allocator allocator = {},
+         const property_list &propList = {})
+    : property_list { propList }
+    , implementation_t { detail::waiter<T, Dimensions, Allocator>(
+                         new detail::buffer<T, Dimensions>
+                         { host_data, r },
+                         is_detached()) } {
+    check_alignment(host_data);
+  }
+
+
+  /** Create a new buffer with associated host memory, using the
+      default allocator
+
+      \param[inout] host_data points to the storage and values used by
+      the buffer
+
+      \param[in] r defines the size
+
+      \param[in] propList are the properties of the buffer
+  */
+  buffer(T *host_data,
+         const range<Dimensions> &r,
+         const property_list &propList)
+    : buffer { host_data, r, Allocator {}, propList } {}
 
 
   /** Create a new buffer with associated host memory from a range
@@ -204,10 +294,14 @@ public:
                 and we do not want to hijack the constructor from a \c
                 sycl::range */
              && (!detail::is_range_v<Range>)
+             // Nor the constructor from a file path, also a C++ range
+             && (!std::is_same_v<std::remove_cvref_t<Range>,
+                                 std::filesystem::path>)
   buffer(Range /* auto std::continuous_range */& host_data,
          Allocator allocator = {})
       : buffer { host_data.begin(),
-                 range { std::ranges::distance(host_data) } } {}
+                 range { std::ranges::distance(host_data) },
+                 allocator } {}
 
   /** Create a new buffer with associated memory, using the data in
       host_data
@@ -254,14 +348,21 @@ public:
       runtime to use the same pointer, a trisycl::mutex_class is
       used.
 
+      \param[in] propList are the properties of the buffer
+
       \todo add this mutex-less constructor to the specification
   */
   buffer(shared_ptr_class<T> host_data,
          const range<Dimensions> &buffer_range,
-         Allocator allocator = {})
-    : implementation_t { detail::waiter(new detail::buffer<T, Dimensions>
-                         { host_data, buffer_range }) }
-  {}
+         Allocator allocator = {},
+         const property_list &propList = {})
+    : property_list { propList }
+    , implementation_t { detail::waiter<T, Dimensions, Allocator>(
+                         new detail::buffer<T, Dimensions>
+                         { host_data, buffer_range },
+                         is_detached()) } {
+    check_alignment(host_data.get());
+  }
 
 
   /** Create a new allocated 1D buffer initialized from the given
@@ -303,9 +404,135 @@ public:
             typename std::iterator_traits<InputIterator>::value_type>
   buffer(InputIterator start_iterator,
          InputIterator end_iterator,
-         Allocator allocator = {}) :
-    implementation_t { detail::waiter(new detail::buffer<T, Dimensions>
-                       { start_iterator, end_iterator }) }
+         Allocator allocator = {},
+         const property_list &propList = {}) :
+    property_list { propList },
+    implementation_t { detail::waiter<T, Dimensions, Allocator>(
+                       new detail::buffer<T, Dimensions>
+                       { start_iterator, end_iterator,
+                         storage_allocator(allocator) },
+                       is_detached()) }
+  {}
+
+
+  /** Create a new allocated 1D buffer initialized from the given
+      elements, using the default allocator
+
+      \param[inout] start_iterator points to the first element to copy
+
+      \param[in] end_iterator points to just after the last element to copy
+
+      \param[in] propList are the properties of the buffer
+  */
+  template <typename InputIterator,
+            typename ValueType =
+            typename std::iterator_traits<InputIterator>::value_type>
+  buffer(InputIterator start_iterator,
+         InputIterator end_iterator,
+         const property_list &propList) :
+    buffer { start_iterator, end_iterator, Allocator {}, propList }
+  {}
+
+
+  /** Create a new buffer backed by a part of a file mapped in memory
+
+      \param[in] fd is the descriptor of the open file, which can be
+      closed once the buffer is created
+
+      \param[in] offset is the position in bytes of the data in the file
+
+      \param[in] r defines the size
+
+      \param[in] mode is \c access::mode::read to map the file
+      read-only or \c access::mode::read_write to write the
+      modifications back to the file, at the latest on buffer
+      destruction
+
+      \param[in] propList are the properties of the buffer
+
+      The data are not read and copied on construction but brought in
+      memory on demand by the page cache of the system. A read-only
+      file is copied into memory managed by the SYCL runtime on the
+      first write access, which is not written back to the file.
+
+      \throw invalid_parameter_error if the file is too short
+
+      This is a triSYCL extension.
+  */
+  buffer(file_descriptor fd,
+         std::size_t offset,
+         const range<Dimensions> &r,
+         access::mode mode = access::mode::read,
+         const property_list &propList = {})
+    : property_list { propList }
+    , implementation_t { detail::waiter<T, Dimensions, Allocator>(
+                         new detail::buffer<T, Dimensions>
+                         { detail::file_mapping { fd.fd, offset,
+                                                  r.size()*sizeof(T),
+                                                  is_writable(mode) },
+                           r,
+                           storage_allocator(Allocator {}) },
+                         is_detached()) }
+  {}
+
+
+  /** Create a new buffer backed by a part of a file mapped in memory
+
+      \param[in] path is the name of the file
+
+      \param[in] r defines the size
+
+      \param[in] offset is the position in bytes of the data in the file
+
+      \param[in] mode is \c access::mode::read to map the file
+      read-only or \c access::mode::read_write to write the
+      modifications back to the file
+
+      \param[in] propList are the properties of the buffer
+
+      \throw invalid_parameter_error if the file cannot be opened or
+      is too short
+
+      This is a triSYCL extension.
+  */
+  buffer(const std::filesystem::path &path,
+         const range<Dimensions> &r,
+         std::size_t offset = 0,
+         access::mode mode = access::mode::read,
+         const property_list &propList = {})
+    : property_list { propList }
+    , implementation_t { detail::waiter<T, Dimensions, Allocator>(
+                         new detail::buffer<T, Dimensions>
+                         { detail::file_mapping { path, offset,
+                                                  r.size()*sizeof(T),
+                                                  is_writable(mode) },
+                           r,
+                           storage_allocator(Allocator {}) },
+                         is_detached()) }
+  {}
+
+
+  /** Create a new 1D buffer backed by a whole file mapped in memory
+
+      \param[in] path is the name of the file, with a size multiple
+      of the element size
+
+      \param[in] mode is \c access::mode::read to map the file
+      read-only or \c access::mode::read_write to write the
+      modifications back to the file
+
+      \param[in] propList are the properties of the buffer
+
+      This is a triSYCL extension.
+  */
+  buffer(const std::filesystem::path &path,
+         access::mode mode = access::mode::read,
+         const property_list &propList = {}) requires (Dimensions == 1)
+    : buffer { path,
+               range<1> { std::filesystem::file_size(path)/sizeof(T) },
+               0,
+               mode,
+               propList }
   {}
 
 
@@ -319,14 +546,23 @@ public:
 
       \param[in] sub_range specifies the size of the sub-buffer
 
-      \todo To be implemented
+      The sub-buffer has to be a contiguous region of \p b, otherwise
+      an \c invalid_object_error is thrown.
+
+      The sub-buffer is tracked as a separate region of \p b, so the
+      kernels accessing disjoint sub-buffers can run concurrently.
 
       \todo Update the specification to replace index by id
   */
   buffer(buffer<T, Dimensions, Allocator> &b,
          const id<Dimensions> &base_index,
          const range<Dimensions> &sub_range,
-         Allocator allocator = {}) { TRISYCL_UNIMPL; }
+         Allocator allocator = {})
+    : implementation_t { detail::waiter<T, Dimensions, Allocator>(
+                         new detail::buffer<T, Dimensions>
+                         { b.implementation->implementation,
+                           base_index, sub_range }) }
+  {}
 
 
 #ifdef TRISYCL_OPENCL
@@ -378,15 +614,40 @@ public:
   accessor<T, Dimensions, Mode, Target>
   get_access(handler &command_group_handler) {
     static_assert(Target == access::target::global_buffer
-                  || Target == access::target::constant_buffer,
-                  "get_access(handler) can only deal with access::global_buffer"
-                  " or access::constant_buffer (for host_buffer accessor"
-                  " do not use a command group handler");
+                  || Target == access::target::constant_buffer
+                  || Target == access::target::host_task,
+                  "get_access(handler) can only deal with access::global_buffer,"
+                  " access::constant_buffer or access::host_task (for"
+                  " host_buffer accessor do not use a command group handler");
     implementation->implementation->template track_access_mode<Mode, Target>();
     return { *this, command_group_handler };
   }
 
 
+  /** Get an accessor to the region of size \p access_range starting at
+      \p access_offset of the buffer, to be used in a kernel
+
+      Only this region is taken into account for the dependencies
+      between the kernels. The accessor is still indexed with the ids
+      of the whole buffer.
+  */
+  template <access::mode Mode,
+            access::target Target = access::target::global_buffer>
+  accessor<T, Dimensions, Mode, Target>
+  get_access(handler &command_group_handler,
+             const range<Dimensions> &access_range,
+             const id<Dimensions> &access_offset = {}) {
+    static_assert(Target == access::target::global_buffer
+                  || Target == access::target::constant_buffer
+                  || Target == access::target::host_task,
+                  "get_access(handler) can only deal with access::global_buffer,"
+                  " access::constant_buffer or access::host_task (for"
+                  " host_buffer accessor do not use a command group handler");
+    implementation->implementation->template track_access_mode<Mode, Target>();
+    return { *this, command_group_handler, access_range, access_offset };
+  }
+
+
   /** Force the buffer to behave like if we had created
       an accessor in write mode.
    */
@@ -411,6 +672,18 @@ public:
   }
 
 
+  /** Suspend a coroutine until the buffer is no longer used by any
+      kernel, with \c co_await
+
+      This is a triSYCL extension to create afterwards a host accessor
+      without blocking the thread running the coroutine, as long as no
+      other kernel using the buffer is submitted in between.
+  */
+  detail::buffer_awaiter operator co_await() const {
+    return { implementation->implementation };
+  }
+
+
   /** Return a range object representing the size of the buffer in
       terms of number of elements in each dimension as passed to the
       constructor
@@ -468,6 +741,12 @@ public:
   }
 
 
+  /// Test if the buffer is a sub-buffer of another buffer
+  bool is_sub_buffer() const {
+    return implementation->implementation->parent != nullptr;
+  }
+
+
   /** Ask for read-only status of the buffer
 
       \todo Add to specification
@@ -537,6 +816,105 @@ public:
       std::forward<Iterator>(finalData));
   }
 
+
+  /** Get an event completed once the buffer has been destroyed,
+      after the final write-back of its data if any
+
+      This is useful with the \c property::buffer::detach_on_destroy
+      property, where the destruction of the buffer does not wait.
+      The event can be requested at any time before the destruction
+      of the buffer.
+
+      This is a triSYCL extension.
+  */
+  event get_write_back_event() const {
+    return std::shared_ptr<detail::event> {
+      std::make_shared<detail::future_event>(
+        implementation->implementation->get_destruction_future()) };
+  }
+
+
+  /** Check if the buffer was constructed with the specified
+      property.
+  */
+  template <typename propertyT>
+  bool has_property() const {
+    return property_list::has_property<propertyT>();
+  }
+
+
+  /** Return a copy of the property that the buffer was
+      constructed with.
+  */
+  template <typename propertyT>
+  propertyT get_property() const {
+    return property_list::get_property<propertyT>();
+  }
+
+private:
+
+  /// Test if the destruction of the buffer does not wait for it
+  bool is_detached() const {
+    return has_property<property::buffer::detach_on_destroy>();
+  }
+
+
+  /** Test if a file mapped with access \p mode is written back
+
+      A buffer of \c const \c T is always mapped read-only.
+  */
+  static bool is_writable(access::mode mode) {
+    return !std::is_const_v<T> && mode != access::mode::read;
+  }
+
+
+  /** Check that the memory provided by the user honors the alignment
+      property of the buffer, if any
+
+      Otherwise \c accessor::get_aligned_pointer() would lie to the
+      compiler about the alignment of the data.
+  */
+  void check_alignment(const void *host_data) const {
+    if (has_property<property::buffer::alignment>()
+        && reinterpret_cast<std::uintptr_t>(host_data)
+           % get_property<property::buffer::alignment>().get_alignment())
+      throw invalid_parameter_error {
+        "The host data are not aligned as required by the buffer "
+        "alignment property" };
+  }
+
+
+  /** Get the allocator of the storage according to the buffer
+      properties
+
+      An aligned storage does not use \p allocator, so these
+      properties cannot be combined with an allocator type other than
+      the default one.
+
+      \throw invalid_parameter_error if the buffer has some alignment
+      or huge page property with a user allocator type
+
+      \todo Align the memory provided by the user allocator instead
+  */
+  detail::any_allocator<std::remove_const_t<T>>
+  storage_allocator(const Allocator &allocator) const {
+    if (has_property<property::buffer::alignment>()
+        || has_property<property::buffer::use_huge_pages>()) {
+      if constexpr (!std::is_same_v<Allocator,
+                                    buffer_allocator<std::remove_const_t<T>>>)
+        throw invalid_parameter_error {
+          "The buffer alignment and huge page properties cannot be used "
+          "with a user allocator" };
+      std::size_t alignment = alignof(T);
+      if (has_property<property::buffer::alignment>())
+        alignment =
+          get_property<property::buffer::alignment>().get_alignment();
+      return detail::aligned_allocator<std::remove_const_t<T>> {
+        alignment, has_property<property::buffer::use_huge_pages>() };
+    }
+    return allocator;
+  }
+
 };
 
 /** A deduction guide to infer the buffer type from the read-write
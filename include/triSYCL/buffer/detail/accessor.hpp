@@ -11,6 +11,7 @@
 
 #include <cstddef>
 #include <memory>
+#include <optional>
 #include <type_traits>
 #include <utility>
 
@@ -23,6 +24,8 @@
 #include "triSYCL/accessor/facade/accessor.hpp"
 #include "triSYCL/command_group/detail/task.hpp"
 #include "triSYCL/detail/debug.hpp"
+#include "triSYCL/id.hpp"
+#include "triSYCL/range.hpp"
 
 namespace trisycl {
 
@@ -65,6 +68,12 @@ class accessor
   */
   std::shared_ptr<detail::buffer<T, Dimensions>> buf;
 
+  /// The first element accessed by a ranged accessor
+  id<Dimensions> access_offset {};
+
+  /// The size of the region accessed by a ranged accessor
+  std::optional<range<Dimensions>> access_range;
+
   /// Where most of the user-facing interface dwells
   using facade = facade::accessor<mixin::accessor<T, Dimensions>>;
 
@@ -92,6 +101,11 @@ class accessor
       : facade { target_buffer->access }
       , buf { target_buffer } {
     target_buffer->template track_access_mode<Mode>();
+    buf->allocate_on_host();
+    buf->materialize({}, is_discard_access());
+    /* The memory may have been allocated or copied on write, so point
+       to its latest version */
+    this->set_access(buf->access);
     TRISYCL_DUMP_T("Create a host accessor write = " << is_write_access());
     static_assert(Target == access::target::host_buffer,
                   "without a handler, access target should be host_buffer");
@@ -117,16 +131,52 @@ class accessor
   */
   accessor(std::shared_ptr<detail::buffer<T, Dimensions>> target_buffer,
            handler& command_group_handler)
+      : accessor { target_buffer, command_group_handler, {}, {} } {}
+
+  /** Construct a device accessor to the region of size \p r starting
+      at \p offset of an existing buffer, or to the whole buffer if
+      there is no \p r
+
+      Only this region is registered in the dependencies of the task.
+  */
+  accessor(std::shared_ptr<detail::buffer<T, Dimensions>> target_buffer,
+           handler& command_group_handler,
+           std::optional<range<Dimensions>> r,
+           const id<Dimensions>& offset)
       : facade { target_buffer->access }
-      , buf { target_buffer } {
+      , buf { target_buffer }
+      , access_offset { offset }
+      , access_range { r } {
+    if (r)
+      for (int i = 0; i != Dimensions; ++i)
+        if (offset[i] + (*r)[i] > target_buffer->get_range()[i])
+          throw invalid_object_error {
+            "The accessed region is out of the buffer" };
     target_buffer->template track_access_mode<Mode>();
     TRISYCL_DUMP_T("Create a kernel accessor write = " << is_write_access());
     static_assert(Target == access::target::global_buffer ||
-                      Target == access::target::constant_buffer,
-                  "access target should be global_buffer or constant_buffer "
-                  "when a handler is used");
+                      Target == access::target::constant_buffer ||
+                      Target == access::target::host_task,
+                  "access target should be global_buffer, constant_buffer "
+                  "or host_task when a handler is used");
     // Register the buffer to the task dependencies
-    task = buffer_add_to_task(buf, &command_group_handler, is_write_access());
+    auto region = access_range
+      ? buffer_region { access_offset, *access_range } : buffer_region {};
+    // Get the read-only data of a copied-on-write buffer where needed
+    target_buffer->materialize(region, is_discard_access());
+    task = buffer_add_to_task(buf, &command_group_handler, is_write_access(),
+                              is_discard_access(), region);
+#ifdef TRISYCL_OPENCL
+    /* A kernel overwriting the buffer on a device does not need any
+       memory on the host */
+    if (Target == access::target::host_task || !is_discard_access()
+        || task->get_queue()->is_host())
+#endif
+      buf->allocate_on_host();
+    /* The registration may have renamed the buffer to some fresh
+       storage or it may have been just allocated, so point to its
+       latest version */
+    this->set_access(buf->access);
   }
 
   /** Register the accessor once a \c std::shared_ptr is created on it
@@ -139,7 +189,20 @@ class accessor
       \todo Double-check with the C++ committee on this issue.
   */
   void register_accessor() {
-    if (!task->get_queue()->is_host()) {
+    if constexpr (Target == access::target::host_task) {
+#ifdef TRISYCL_OPENCL
+      // To keep alive this accessor in the following lambda
+      auto acc = this->shared_from_this();
+      /* Like for a host accessor, make the data up-to-date on the
+         host, but only when the host task is about to run */
+      task->add_prelude([=] {
+        trisycl::context ctx;
+        acc->buf->update_buffer_state(ctx, Mode, acc->buffer_size(),
+                                      acc->data());
+      });
+#endif
+    }
+    else if (!task->get_queue()->is_host()) {
       // To keep alive this accessor in the following lambdas
       auto acc = this->shared_from_this();
       // Attach the accessor to the task and get its order
@@ -163,6 +226,50 @@ class accessor
   /// Get the buffer used to create the accessor
   detail::buffer<T, Dimensions>& get_buffer() { return *buf; }
 
+  /** Get the range of the accessed region, which is the whole buffer
+      for an accessor without access range */
+  auto get_range() const {
+    return access_range ? *access_range : facade::get_range();
+  }
+
+  /// Get the number of elements of the accessed region
+  std::size_t get_count() const { return get_range().size(); }
+
+  /// Get the size in bytes of the accessed region
+  std::size_t get_size() const { return get_count() * sizeof(T); }
+
+  /// Get the first element of the accessed region
+  auto get_offset() const { return access_offset; }
+
+private:
+
+  /// Get the size in bytes of the whole buffer
+  std::size_t buffer_size() const { return facade::get_size(); }
+
+
+  /** Get the offset and the length in bytes of the contiguous part of
+      the buffer containing the accessed region
+
+      Since the buffer is in row-major order, it spans from the first
+      to the last element of the region.
+  */
+  std::pair<std::size_t, std::size_t> accessed_bytes() const {
+    if (!access_range)
+      return { 0, buffer_size() };
+    if (access_range->size() == 0)
+      return { 0, 0 };
+    auto buffer_range = facade::get_range();
+    std::size_t first = 0;
+    std::size_t last = 0;
+    for (int i = 0; i != Dimensions; ++i) {
+      first = first*buffer_range[i] + access_offset[i];
+      last = last*buffer_range[i] + access_offset[i] + (*access_range)[i] - 1;
+    }
+    return { first*sizeof(T), (last + 1 - first)*sizeof(T) };
+  }
+
+public:
+
   /** Test if the accessor has a read access right
 
       \todo Strangely, it is not really constexpr because it is not a
@@ -190,6 +297,13 @@ class accessor
            Mode == access::mode::discard_read_write;
   }
 
+  /** Test if the accessor overwrites the buffer without reading its
+      previous content */
+  constexpr bool is_discard_access() const {
+    return Mode == access::mode::discard_write ||
+           Mode == access::mode::discard_read_write;
+  }
+
  private:
 #ifdef TRISYCL_OPENCL
   // The following function are used from handler
@@ -210,7 +324,9 @@ class accessor
        the buffer doesn't already exists or if the data is not up to date
     */
     auto ctx = task->get_queue()->get_context();
-    buf->update_buffer_state(ctx, Mode, facade::get_size(), facade::data());
+    auto [offset, length] = accessed_bytes();
+    buf->update_buffer_state(ctx, Mode, buffer_size(), facade::data(),
+                             offset, length);
   }
 
   /// Does nothing
@@ -9,10 +9,16 @@
     License. See LICENSE.TXT for details.
 */
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <type_traits>
+#include <vector>
+
+#include <unistd.h>
 
 // \todo Use C++17 optional when it is mainstream
 #include <boost/optional.hpp>
@@ -22,6 +28,11 @@
 #include "triSYCL/buffer/detail/accessor.hpp"
 #include "triSYCL/buffer/detail/buffer_base.hpp"
 #include "triSYCL/buffer/detail/buffer_waiter.hpp"
+#include "triSYCL/detail/any_allocator.hpp"
+#include "triSYCL/detail/file_mapping.hpp"
+#include "triSYCL/detail/parallel_copy.hpp"
+#include "triSYCL/exception.hpp"
+#include "triSYCL/id.hpp"
 #include "triSYCL/range.hpp"
 
 namespace trisycl::detail {
@@ -50,9 +61,10 @@ class buffer
 
   /** The allocator to be used when some memory is needed
 
-      \todo Implement user-provided allocator
+      It is type-erased so that the allocator of the user does not
+      change the type of the implementation used by the accessors.
   */
-  std::allocator<typename mixin::value_type> alloc;
+  detail::any_allocator<typename mixin::value_type> alloc;
 
   /** If some allocation is requested on the host for the buffer
       memory, this is where the memory is attached to.
@@ -70,6 +82,10 @@ class buffer
   /// Keep the shared pointer used to create the buffer
   shared_ptr_class<T> input_shared_pointer;
 
+  /** Keep the file mapped in memory backing the buffer, unmapped
+      after the final write-back */
+  std::optional<detail::file_mapping> mapping;
+
   /// Track if the buffer memory is backed by user-provided host memory
   bool data_host = false;
 
@@ -77,17 +93,47 @@ class buffer
       modification occurs */
   bool copy_if_modified = false;
 
+  /** The read-only data still to be copied chunk by chunk into \c
+      allocation after a copy-on-write */
+  typename mixin::pointer copy_source = nullptr;
+
+  /// The number of elements of a copy-on-write chunk, about a page
+  std::size_t chunk_size = 1;
+
+  /// For each chunk, track if it has still to be copied from \c copy_source
+  std::vector<bool> pending_chunks;
+
+  /// The number of chunks still to be copied
+  std::size_t remaining_chunks = 0;
+
+  /// Protect the chunk copies from concurrent accessor constructions
+  std::mutex chunks_lock;
+
   // Track if data have been modified
   bool modified = false;
 
+  /** Track if the host memory is only allocated on the first use of
+      the buffer requiring it */
+  bool lazy_allocation = false;
+
+  /// To allocate the lazy host memory only once
+  std::once_flag lazy_allocation_done;
+
   /// Track the host context
   trisycl::context host_context { trisycl::device {} };
 
  public:
-  /// Create a new read-write buffer of size \param r
-  buffer(const range<Dimensions>& r)
-      /// \todo Lazily allocate memory since it might not be used on host
-      : mixin { allocate_buffer(r), r } {}
+  /** Create a new read-write buffer of size \param r
+
+      The memory is only allocated on the host when the buffer is used
+      in a way requiring it, since a scratch buffer might be only used
+      on a device.
+  */
+  buffer(const range<Dimensions>& r,
+         detail::any_allocator<typename mixin::value_type> a = {})
+      : mixin { nullptr, r }
+      , alloc { std::move(a) }
+      , lazy_allocation { true } {}
 
   /** Create a new read-write buffer from \param host_data of size
       \param r without further allocation */
@@ -109,12 +155,14 @@ class buffer
   */
   template <typename Dependent = T,
             typename = std::enable_if_t<!std::is_const<Dependent>::value>>
-  buffer(const T* host_data, const range<Dimensions>& r)
+  buffer(const T* host_data, const range<Dimensions>& r,
+         detail::any_allocator<typename mixin::value_type> a = {})
       : /* The buffer is read-only, even if the internal multidimensional
            wrapper is not. If a write accessor is requested, there should
            be a copy on write. So this pointer should not be written and
            this const_cast should be acceptable. */
       mixin { const_cast<T*>(host_data), r }
+      , alloc { std::move(a) }
       , data_host { true }
       ,
       /* Set copy_if_modified to true, so that if an accessor with write
@@ -134,23 +182,78 @@ class buffer
       , input_shared_pointer { host_data }
       , data_host { true } {}
 
+  /** Create a new buffer backed by the file mapped by \param m with
+      size \param r
+
+      A read-only mapping is used with the copy-on-write mechanism, so
+      that the first write access copies the data into internal
+      writable memory.
+  */
+  buffer(detail::file_mapping&& m, const range<Dimensions>& r,
+         detail::any_allocator<typename mixin::value_type> a = {})
+      : mixin { static_cast<T*>(m.data()), r }
+      , alloc { std::move(a) }
+      , mapping { std::move(m) }
+      , data_host { true }
+      , copy_if_modified { !mapping->is_writable() } {}
+
   /// Create a new allocated 1D buffer from the given elements
   template <typename Iterator>
-  buffer(Iterator start_iterator, Iterator end_iterator)
-      : mixin { allocate_buffer(std::distance(start_iterator, end_iterator)),
+  buffer(Iterator start_iterator, Iterator end_iterator,
+         detail::any_allocator<typename mixin::value_type> a = {})
+      : mixin { nullptr,
                 range<1> { static_cast<std::size_t>(
-                    std::distance(start_iterator, end_iterator)) } } {
+                    std::distance(start_iterator, end_iterator)) } }
+      , alloc { std::move(a) } {
+    /* Allocate only once the allocator is constructed, after the
+       mixin base */
+    auto r = mixin::get_range();
+    mixin::update(allocate_buffer(r), r);
     assign(start_iterator, end_iterator);
   }
 
-  /** Create a new sub-buffer without allocation to have separate
-      accessors later
+  /** Create a new sub-buffer aliasing the contiguous region of \param
+      b starting at \param base_index with size \param sub_range
 
-      \todo To implement and deal with reference counting
-  buffer(buffer<T, Dimensions> b,
-         index<Dimensions> base_index,
-         range<Dimensions> sub_range)
+      The sub-buffer has its own accessors but shares the storage and
+      the access history of \p b, so the tasks accessing disjoint
+      sub-buffers can run concurrently.
+
+      Since the sub-buffer keeps \p b alive, it has to be destroyed
+      before the last user buffer of \p b if this one waits for a
+      write-back on destruction.
+
+      \todo Make the sub-buffers coherent with their parent on OpenCL
+      devices
   */
+  buffer(std::shared_ptr<buffer> b,
+         const id<Dimensions>& base_index,
+         const range<Dimensions>& sub_range)
+      : mixin { nullptr, sub_range } {
+    auto r = b->get_range();
+    /* With the row-major layout, the region is contiguous if it only
+       spans entire rows of the dimensions after the first one wider
+       than 1 */
+    bool inner = false;
+    for (int i = 0; i != Dimensions; ++i) {
+      if (base_index[i] + sub_range[i] > r[i])
+        throw invalid_object_error { "The sub-buffer exceeds its buffer" };
+      if (inner && (base_index[i] != 0 || sub_range[i] != r[i]))
+        throw invalid_object_error { "The sub-buffer is not contiguous" };
+      inner = inner || sub_range[i] != 1;
+    }
+    // The aliased storage has to exist and to be writable
+    b->allocate_on_host();
+    b->copy_on_write();
+    // And it has to stay where it is
+    b->pin();
+    std::size_t offset = 0;
+    for (int i = 0; i != Dimensions; ++i)
+      offset = offset*r[i] + base_index[i];
+    mixin::update(b->data() + offset, sub_range);
+    parent_region = { base_index, sub_range };
+    parent = std::move(b);
+  }
 
   /// \todo Allow CLHPP objects too?
   ///
@@ -163,23 +266,29 @@ class buffer
   /** The buffer content may be copied back on destruction to some
       final location */
   ~buffer() {
-#ifdef TRISYCL_OPENCL
-    /* We ensure that the host has the most up-to-date version of the data
-       before the buffer is destroyed. This is necessary because we do not
-       systematically transfer the data back from a device with
-       \c copy_back_cl_buffer any more.
-       \todo Optimize for the case the buffer is not based on host memory
-    */
-    call_update_buffer_state(host_context, access::mode::read,
-                             mixin::get_size(), mixin::data());
-
-#endif
-    if (modified && final_write_back)
-      (*final_write_back)();
+    write_back();
     // Allocate explicitly allocated memory if required
     deallocate_buffer();
   }
 
+
+  /** Detach the buffer from its SYCL user buffer while some command
+      graph still keeps it alive
+
+      The recorded command graphs cannot be replayed anymore.
+
+      \param[in] wait_for_write_back is true to wait for the current
+      users of the buffer and to write the data back now instead of on
+      the destruction of the last command graph
+  */
+  void release(bool wait_for_write_back) {
+    released = true;
+    if (wait_for_write_back) {
+      wait();
+      write_back();
+    }
+  }
+
   /** Enforce the buffer to be considered as being modified.
       Same as creating an accessor with write access.
    */
@@ -199,26 +308,150 @@ class buffer
         Mode == access::mode::discard_read_write ||
         Mode == access::mode::atomic) {
       modified = true;
-      if (copy_if_modified) {
-        // Implement the allocate & copy-on-write optimization
-        copy_if_modified = false;
-        // Since the mixin store the geometry, keep a copy before updating
-        auto current_access = mixin::access;
-        /* The range is actually computed from \c access itself, so
-           save it */
+      copy_on_write();
+      // Writing a sub-buffer writes its parent
+      if (parent)
+        static_cast<buffer&>(*parent).mark_as_written();
+    }
+  }
+
+  /** Switch from read-only host data to internal writable memory
+      before they are modified, if needed
+
+      The data are not copied here but chunk by chunk by \c
+      materialize() when a region of the buffer is accessed, so that
+      a large read-only buffer with only a few modified elements does
+      not need to be copied entirely.
+  */
+  void copy_on_write() {
+    if (copy_if_modified) {
+      // Implement the allocate & copy-on-write optimization
+      copy_if_modified = false;
+      // Keep the read-only data to be copied later
+      copy_source = mixin::data();
+      /* The range is actually computed from \c access itself, so
+         save it */
+      auto current_range = mixin::get_range();
+      allocate_buffer(current_range);
+      /* Update the mixin accessor to point to the new allocated
+         memory instead */
+      mixin::update(allocation, current_range);
+      // Copy about a page at a time
+      auto page_size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+      chunk_size = std::max<std::size_t>(1, page_size/sizeof(T));
+      std::lock_guard lock { chunks_lock };
+      remaining_chunks = (mixin::get_count() + chunk_size - 1)/chunk_size;
+      pending_chunks.assign(remaining_chunks, true);
+      /* Now the data of the buffer is no longer backed-up by host
+         user provided memory */
+      data_host = false;
+    }
+  }
+
+  /** Copy the read-only data of the chunks containing the region \p r
+      which have not been copied yet after a copy-on-write
+
+      This is to be called before the memory of the region is used.
+
+      \param[in] discard is true if the previous content of the region
+      is not used
+  */
+  void materialize(const buffer_region& r = {}, bool discard = false) {
+    // The storage of a sub-buffer is the one of its parent
+    if (parent) {
+      static_cast<buffer&>(*parent).materialize(r.within(parent_region),
+                                                discard);
+      return;
+    }
+    std::lock_guard lock { chunks_lock };
+    if (remaining_chunks == 0)
+      return;
+    if (discard && r.is_whole()) {
+      // Nothing is worth copying
+      pending_chunks.assign(pending_chunks.size(), false);
+      remaining_chunks = 0;
+      return;
+    }
+    /* In row-major order, the region spans from its first to its last
+       element */
+    auto current_range = mixin::get_range();
+    std::size_t first = 0;
+    std::size_t last = 0;
+    if constexpr (Dimensions > buffer_region::max_dimensions)
+      // The region does not keep all the dimensions, so take them all
+      last = mixin::get_count() - 1;
+    else
+      for (int i = 0; i != Dimensions; ++i) {
+        auto end = std::min(r.end[i], current_range[i]);
+        if (r.begin[i] >= end)
+          // Empty region
+          return;
+        first = first*current_range[i] + r.begin[i];
+        last = last*current_range[i] + end - 1;
+      }
+    auto last_chunk = last/chunk_size;
+    for (auto c = first/chunk_size; c <= last_chunk;) {
+      if (!pending_chunks[c]) {
+        ++c;
+        continue;
+      }
+      // Copy at once a run of consecutive pending chunks
+      auto start = c*chunk_size;
+      for (; c <= last_chunk && pending_chunks[c]; ++c) {
+        pending_chunks[c] = false;
+        --remaining_chunks;
+      }
+      auto end = std::min(c*chunk_size, mixin::get_count());
+      detail::parallel_uninitialized_copy_n(copy_source + start, end - start,
+                                            allocation + start);
+    }
+  }
+
+  /** Allocate the host memory of a lazily allocated buffer if it is
+      not already done
+
+      This is to be called before any use of the buffer memory on the
+      host.
+  */
+  void allocate_on_host() {
+    if (lazy_allocation)
+      std::call_once(lazy_allocation_done, [&] {
         auto current_range = mixin::get_range();
         allocate_buffer(current_range);
-        /* Update the mixin accessor to point to the new allocated
-           memory instead */
         mixin::update(allocation, current_range);
-        // Then copy the read-only data to the new allocated place
-        std::uninitialized_copy_n(current_access.data_handle(), mixin::get_count(),
-                                  mixin::data());
-        /* Now the data of the buffer is no longer backed-up by host
-           user provided memory */
-        data_host = false;
+      });
+  }
+
+  /** Give some fresh storage to the buffer when it is discarded while
+      the previous version is still used by some tasks
+
+      Only the storage owned by the runtime can be renamed, since the
+      user-provided host memory has to be the final location of the
+      data.
+
+      \return the previous storage, released when the last task using
+      it releases it, or an empty pointer if the buffer cannot be
+      renamed
+  */
+  std::shared_ptr<void> rename() override {
+#ifdef TRISYCL_OPENCL
+    // The device-side cache only tracks a single version of the buffer
+    return {};
+#else
+    if (data_host || copy_if_modified || !allocation)
+      return {};
+    std::shared_ptr<void> retired {
+      allocation,
+      [a = alloc, count = mixin::get_count()]
+      (typename mixin::non_const_pointer p) mutable {
+        a.deallocate(p, count);
       }
-    }
+    };
+    auto current_range = mixin::get_range();
+    allocate_buffer(current_range);
+    mixin::update(allocation, current_range);
+    return retired;
+#endif
   }
 
   /** Set the weak pointer as destination for write-back on buffer
@@ -228,7 +461,8 @@ class buffer
     // Capture this by reference is enough since the buffer will still exist
     final_write_back = [this, final_data = std::move(final_data)] {
       if (auto sptr = final_data.lock()) {
-        std::copy_n(mixin::data(), mixin::get_count(), sptr.get());
+        detail::parallel_copy_n(mixin::data(), mixin::get_count(),
+                                sptr.get());
       }
     };
   }
@@ -250,7 +484,7 @@ class buffer
                        "const iterator is not allowed");*/
     // Capture this by reference is enough since the buffer will still exist
     final_write_back = [this, final_data = std::move(final_data)] {
-      std::copy_n(mixin::data(), mixin::get_count(), final_data);
+      detail::parallel_copy_n(mixin::data(), mixin::get_count(), final_data);
     };
   }
 
@@ -273,10 +507,17 @@ class buffer
 
       Use 2 different iterator types since in C++20 ranges it is now
       the case.
+
+      The copy is done in parallel when the size is known up-front.
   */
   template <typename StartIter, typename EndIter>
   void assign(StartIter start_iterator, EndIter end_iterator) {
-    std::copy(start_iterator, end_iterator, mixin::data());
+    if constexpr (std::sized_sentinel_for<EndIter, StartIter>)
+      detail::parallel_copy_n(start_iterator,
+                              end_iterator - start_iterator,
+                              mixin::data());
+    else
+      std::copy(start_iterator, end_iterator, mixin::data());
   }
 
   /** Function pair to work around the fact that T might be a \c const type.
@@ -309,7 +550,7 @@ class buffer
       wait for, otherwise an empty \c optional
       \todo Make the function private again
   */
-  boost::optional<std::future<void>> get_destructor_future() {
+  boost::optional<std::shared_future<void>> get_destructor_future() {
     /* If there is only 1 shared_ptr user of the buffer, this is the
        caller of this function, the \c buffer_waiter, so there is no
        need to get a \ future otherwise there will be a dead-lock if
@@ -322,15 +563,40 @@ class buffer
     // If the buffer's destruction triggers a write-back, wait
     if ((shared_from_this().use_count() > 2) && modified &&
         (final_write_back || data_host)) {
-      // Create a promise to wait for
-      notify_buffer_destructor = std::promise<void> {};
-      // And return the future to wait for it
-      return notify_buffer_destructor->get_future();
+      // Return the future of the destruction to wait for it
+      return get_destruction_future();
     }
     return boost::none;
   }
 
  private:
+
+  /** Copy the buffer content back to its final location, if any and
+      if it has been modified since the last write-back */
+  void write_back() {
+#ifdef TRISYCL_OPENCL
+    /* We ensure that the host has the most up-to-date version of the data
+       before the buffer is destroyed. This is necessary because we do not
+       systematically transfer the data back from a device with
+       \c copy_back_cl_buffer any more.
+       If the buffer has never been used on the host, there is no
+       need to get the data back, unless there is a final write-back.
+    */
+    if (mixin::data() || (modified && final_write_back)) {
+      allocate_on_host();
+      call_update_buffer_state(host_context, access::mode::read,
+                               mixin::get_size(), mixin::data());
+    }
+#endif
+    if (modified && final_write_back) {
+      // The buffer may have been marked as written without any access
+      allocate_on_host();
+      materialize();
+      (*final_write_back)();
+      modified = false;
+    }
+  }
+
   // Allow buffer_waiter destructor to access get_destructor_future()
   // friend detail::buffer_waiter<T, Dimensions>::~buffer_waiter();
   /* \todo Work around to Clang bug
@@ -350,8 +616,10 @@ class buffer
 template <typename BufferDetail>
 static std::shared_ptr<detail::task>
 buffer_add_to_task(BufferDetail buf, handler* command_group_handler,
-                   bool is_write_mode) {
-  return buf->add_to_task(command_group_handler, is_write_mode);
+                   bool is_write_mode, bool is_discard_mode = false,
+                   const buffer_region& r = {}) {
+  return buf->add_to_task(command_group_handler, is_write_mode,
+                          is_discard_mode, r);
 }
 
 /// @} End the data Doxygen group
@@ -10,21 +10,30 @@
     License. See LICENSE.TXT for details.
 */
 
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <coroutine>
 #ifdef TRISYCL_OPENCL
 #include <boost/compute.hpp>
 #endif
 // \todo Use C++17 optional when it is mainstream
 #include <boost/optional.hpp>
-#include <condition_variable>
 #include <future>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "triSYCL/command_group/detail/task.hpp"
 #include "triSYCL/context.hpp"
+#include "triSYCL/detail/atomic_wait.hpp"
+#include "triSYCL/detail/executor.hpp"
+#include "triSYCL/detail/small_vector.hpp"
+#include "triSYCL/id.hpp"
+#include "triSYCL/range.hpp"
 
 namespace trisycl {
 
@@ -39,10 +48,95 @@ struct buffer_base;
     @{
 */
 
+struct buffer_region;
+
 inline static std::shared_ptr<detail::task>
 add_buffer_to_task(handler *command_group_handler,
                    std::shared_ptr<detail::buffer_base> b,
-                   bool is_write_mode);
+                   bool is_write_mode,
+                   bool is_discard_mode,
+                   const buffer_region &r);
+
+inline static bool task_is_completed(const std::shared_ptr<detail::task> &t);
+
+inline static bool task_keep_alive(const std::shared_ptr<detail::task> &t,
+                                   std::shared_ptr<void> resource);
+
+inline static bool
+task_in_same_in_order_queue(const std::shared_ptr<detail::task> &t,
+                            const std::shared_ptr<detail::task> &other);
+
+/** A region of a buffer, as a box in the index space of the buffer
+
+    The dimensions not used by the buffer are unbounded.
+*/
+struct buffer_region {
+  /// Enough for all the SYCL buffer dimensions
+  static constexpr int max_dimensions = 3;
+
+  static constexpr auto unbounded = std::numeric_limits<std::size_t>::max();
+
+  /// The first index of the box in each dimension
+  std::array<std::size_t, max_dimensions> begin { 0, 0, 0 };
+
+  /// The index just after the box in each dimension
+  std::array<std::size_t, max_dimensions> end {
+    unbounded, unbounded, unbounded
+  };
+
+  /// The whole buffer
+  buffer_region() = default;
+
+  /** The box of size \p r starting at \p offset
+
+      For more than \c max_dimensions dimensions, the leading ones are
+      folded into a first unbounded dimension, so the region is larger
+      than the box but never the whole buffer.
+  */
+  template <int Dimensions>
+  buffer_region(const id<Dimensions> &offset, const range<Dimensions> &r) {
+    constexpr int folded =
+      Dimensions > max_dimensions ? Dimensions - max_dimensions + 1 : 0;
+    for (int i = folded; i != Dimensions; ++i) {
+      auto d = i - folded + (folded != 0);
+      begin[d] = offset[i];
+      end[d] = offset[i] + r[i];
+    }
+  }
+
+  /// Test if the region covers the whole buffer
+  bool is_whole() const {
+    return *this == buffer_region {};
+  }
+
+  bool overlaps(const buffer_region &other) const {
+    for (int i = 0; i != max_dimensions; ++i)
+      if (!(begin[i] < other.end[i] && other.begin[i] < end[i]))
+        return false;
+    return true;
+  }
+
+  bool covers(const buffer_region &other) const {
+    for (int i = 0; i != max_dimensions; ++i)
+      if (!(begin[i] <= other.begin[i] && other.end[i] <= end[i]))
+        return false;
+    return true;
+  }
+
+  /// Translate a region relative to \p outer, clamped to it
+  buffer_region within(const buffer_region &outer) const {
+    buffer_region r;
+    for (int i = 0; i != max_dimensions; ++i) {
+      auto size = outer.end[i] - outer.begin[i];
+      r.begin[i] = outer.begin[i] + std::min(begin[i], size);
+      r.end[i] = outer.begin[i] + std::min(end[i], size);
+    }
+    return r;
+  }
+
+  bool operator==(const buffer_region &) const = default;
+};
+
 
 /** Factorize some template independent buffer aspects in a base class
  */
@@ -51,15 +145,54 @@ struct buffer_base : public std::enable_shared_from_this<buffer_base> {
   //// Keep track of the number of kernel accessors using this buffer
   std::atomic<size_t> number_of_users;
 
-  /// Track the latest task to produce this buffer
-  std::weak_ptr<detail::task> latest_producer;
-  /// To protect the access to latest_producer
-  std::mutex latest_producer_mutex;
+  /// An access of a task to a region of the buffer
+  struct access_record {
+    std::weak_ptr<detail::task> t;
+    buffer_region r;
+    bool is_write;
+  };
+
+  /** The access history of the buffer, used to build the task graph
 
-  /// To signal when this buffer ready
-  std::condition_variable ready;
-  /// To protect the access to the condition variable
-  std::mutex ready_mutex;
+      It is made of the latest tasks accessing each region of the
+      buffer. A write to a region hides the previous accesses to it,
+      so the tasks reading it since then can run concurrently, as well
+      as the tasks accessing disjoint regions.
+  */
+  std::vector<access_record> history;
+  /// To protect the access to the history
+  std::mutex history_mutex;
+
+  /** Prevent the renaming of the buffer storage, because some
+      sub-buffers keep pointing to it */
+  std::atomic<bool> pinned = false;
+
+  /** Number of command graphs with some recorded accesses to this
+      buffer, which also prevent its renaming while they exist */
+  std::atomic<std::size_t> recording_graphs = 0;
+
+  /** The SYCL user buffer has been destroyed while some command graph
+      still refers to this implementation */
+  std::atomic<bool> released = false;
+
+  /** The buffer containing this sub-buffer, which keeps the access
+      history of both, or nothing for a plain buffer */
+  std::shared_ptr<buffer_base> parent;
+
+  /// The region of the parent storage aliased by this sub-buffer
+  buffer_region parent_region;
+
+  /** Number of threads or continuations waiting for the buffer to be
+      no longer in use */
+  std::atomic<std::size_t> waiters = 0;
+
+  /** The continuations, such as suspended coroutines, to execute
+      when the buffer is no longer in use
+
+      Protected by \c continuations_mutex */
+  std::vector<detail::executor::work> continuations;
+  /// To protect the continuations
+  std::mutex continuations_mutex;
 
   /** If the SYCL user buffer destructor is blocking, use this to
       block until this buffer implementation is destroyed.
@@ -68,6 +201,12 @@ struct buffer_base : public std::enable_shared_from_this<buffer_base> {
       waiting */
   boost::optional<std::promise<void>> notify_buffer_destructor;
 
+  /// The future of \c notify_buffer_destructor, shared by the waiters
+  std::shared_future<void> destruction;
+
+  /// To create the destruction notification only once
+  std::once_flag destruction_requested;
+
   /// To track contexts in which the data is up-to-date
   std::unordered_set<trisycl::context> fresh_ctx;
 
@@ -84,76 +223,246 @@ struct buffer_base : public std::enable_shared_from_this<buffer_base> {
       \todo Use lazy allocation for the context tracking set
    */
   buffer_base() : number_of_users { 0 },
-                  fresh_ctx { trisycl::context {} } {}
+                  fresh_ctx { trisycl::context {} } {
+    /* Create the executor before the buffer, so that a buffer with a
+       static storage duration is destroyed before the executor used
+       by its final write-back */
+    detail::executor::instance();
+  }
 
 
   /// The destructor waits for not being used anymore
   ~buffer_base() {
-    wait();
+    wait_for_users();
     // If there is the last SYCL user buffer waiting, notify it
     if (notify_buffer_destructor)
       notify_buffer_destructor->set_value();
   }
 
 
-  /// Wait for this buffer to be ready, which is no longer in use
-  void wait() {
-    std::unique_lock<std::mutex> ul { ready_mutex };
-    ready.wait(ul, [&] {
-        // When there is no producer for this buffer, we are ready to use it
-        return number_of_users == 0;
+  /** Get a future ready once this buffer implementation has been
+      destroyed, after its final write-back if any */
+  std::shared_future<void> get_destruction_future() {
+    std::call_once(destruction_requested, [&] {
+        notify_buffer_destructor = std::promise<void> {};
+        destruction = notify_buffer_destructor->get_future().share();
       });
+    return destruction;
   }
 
 
-  /// Mark this buffer in use by a task
+  /** Wait for this buffer to be ready, which is no longer in use
+
+      A sub-buffer also waits for its parent, which may be used by
+      some tasks accessing the same storage.
+  */
+  void wait() {
+    wait_for_users();
+    if (parent)
+      parent->wait();
+  }
+
+
+  /** Mark this buffer in use by a task
+
+      A sub-buffer is also marked in use in its parent, so that the
+      parent waits for the tasks using its storage.
+  */
   void use() {
     // Increment the use count
     ++number_of_users;
+    if (parent)
+      parent->use();
   }
 
 
   /// A task has released the buffer
   void release() {
-    std::unique_lock<std::mutex> lock { ready_mutex };
-    if (--number_of_users == 0) {
-      // Micro-optimization: unlock before the notification
-      // https://en.cppreference.com/w/cpp/thread/condition_variable/notify_all
-      lock.unlock();
+    if (--number_of_users == 0 && waiters != 0) {
       // Notify the host consumers or the buffer destructor that it is ready
-      ready.notify_all();
+      number_of_users.notify_all();
+      resume_continuations();
     }
+    if (parent)
+      parent->release();
   }
 
 
-  /// Return the latest producer for the buffer
-  std::shared_ptr<detail::task> get_latest_producer() {
-    std::lock_guard<std::mutex> lg { latest_producer_mutex };
-    // Return the valid shared_ptr to the task, if any
-    return latest_producer.lock();
+  /** Register a continuation to execute by the executor when the
+      buffer is no longer in use
+
+      \return false if the buffer is already not in use, so the
+      continuation has not been registered
+  */
+  bool add_continuation(detail::executor::work c) {
+    /* Register as a waiter before checking the users, so that a
+       concurrent release() either sees the waiter or is seen here */
+    ++waiters;
+    std::lock_guard<std::mutex> lg { continuations_mutex };
+    if (number_of_users == 0) {
+      --waiters;
+      return false;
+    }
+    continuations.push_back(std::move(c));
+    return true;
   }
 
 
-  /** Return the latest producer for the buffer and set another
-      future producer
-  */
-  std::shared_ptr<detail::task>
-  set_latest_producer(std::weak_ptr<detail::task> newer_latest_producer) {
-    std::lock_guard<std::mutex> lg { latest_producer_mutex };
-    using std::swap;
+  /// Submit the registered continuations to the executor
+  void resume_continuations() {
+    decltype(continuations) ready;
+    {
+      std::lock_guard<std::mutex> lg { continuations_mutex };
+      ready.swap(continuations);
+      waiters -= ready.size();
+    }
+    for (auto &c : ready)
+      detail::executor::instance()->submit(std::move(c));
+  }
+
 
-    swap(newer_latest_producer, latest_producer);
-    // Return the valid shared_ptr to the previous producing task, if any
-    return newer_latest_producer.lock();
+  /** Record an access of a task to the buffer in the history
+
+      \param[in] t is the task accessing the buffer
+
+      \param[in] is_write_mode is true if the task may modify the buffer
+
+      \param[in] is_discard_mode is true if the task overwrites the
+      buffer without reading it
+
+      \param[in] r is the region of the buffer accessed by the task
+
+      \return the tasks that have to be completed before \p t can
+      access the buffer: the previous writers of an overlapping region
+      for a read (RAW) and, for a write, also the readers since then
+      (WAR) since the previous writers are already ordered before them
+      (WAW)
+
+      If the whole buffer is discarded while some previous tasks are
+      still running, the buffer is renamed to some fresh storage
+      instead, removing these false dependencies. The previous version
+      is kept alive by the previous tasks up to their completion.
+
+      A sub-buffer records its accesses in the history of its parent,
+      in the region it aliases.
+  */
+  detail::small_vector<std::shared_ptr<detail::task>, 4>
+  register_access(const std::shared_ptr<detail::task> &t,
+                  bool is_write_mode,
+                  bool is_discard_mode = false,
+                  buffer_region r = {}) {
+    if (parent)
+      /* The storage of a sub-buffer is the one of its parent, so it
+         cannot be renamed */
+      return parent->register_access(t, is_write_mode, false,
+                                     r.within(parent_region));
+
+    detail::small_vector<std::shared_ptr<detail::task>, 4> dependencies;
+    std::lock_guard<std::mutex> lg { history_mutex };
+
+    for (auto &a : history)
+      if ((is_write_mode || a.is_write) && a.r.overlaps(r))
+        if (auto p = a.t.lock())
+          dependencies.push_back(std::move(p));
+    if (is_write_mode) {
+      if (is_discard_mode && !pinned && !is_recorded() && r.is_whole()
+          && std::ranges::none_of(dependencies,
+                                  [&] (auto &d) { return d == t; })
+          /* The previous tasks of the same in-order queue are
+             already ordered before this one, so they do not delay it */
+          && std::ranges::any_of(dependencies, [&] (auto &d) {
+              return !task_in_same_in_order_queue(t, d)
+                && !task_is_completed(d);
+            }))
+        if (auto retired = rename()) {
+          TRISYCL_DUMP_T("Buffer " << this << " renamed by task " << t);
+          for (auto &d : dependencies)
+            task_keep_alive(d, retired);
+          // The new version does not depend on the previous tasks
+          dependencies.clear();
+        }
+      // The new writer hides all the previous accesses to its region
+      std::erase_if(history, [&] (auto &a) {
+          return a.t.expired() || r.covers(a.r);
+        });
+      history.push_back({ t, r, true });
+    }
+    else {
+      // Forget about the completed tasks to keep the history short
+      std::erase_if(history, [&] (auto &a) { return a.t.expired(); });
+      if (std::ranges::none_of(history, [&] (auto &a) {
+            return a.t.lock() == t && a.r.covers(r); }))
+        history.push_back({ t, r, false });
+    }
+    return dependencies;
   }
 
 
-  /// Add a buffer to the task running the command group
+  /** Add a buffer to the task running the command group, accessing
+      only the region \p r of the buffer */
   std::shared_ptr<detail::task>
-  add_to_task(handler *command_group_handler, bool is_write_mode) {
+  add_to_task(handler *command_group_handler, bool is_write_mode,
+              bool is_discard_mode = false, const buffer_region &r = {}) {
     return add_buffer_to_task(command_group_handler,
                               shared_from_this(),
-                              is_write_mode);
+                              is_write_mode,
+                              is_discard_mode,
+                              r);
+  }
+
+
+  /// Prevent any later renaming of the buffer storage
+  void pin() {
+    pinned = true;
+  }
+
+
+  /** Mark the buffer and the buffers containing it as used by one
+      more command graph, which keeps its accessors to the current
+      storage */
+  void record() {
+    ++recording_graphs;
+    if (parent)
+      parent->record();
+  }
+
+
+  /** Mark the buffer and the buffers containing it as no longer used
+      by a command graph being destroyed */
+  void unrecord() {
+    --recording_graphs;
+    if (parent)
+      parent->unrecord();
+  }
+
+
+  /// Test if some existing command graph uses the buffer
+  bool is_recorded() const {
+    return recording_graphs != 0;
+  }
+
+
+  /** Test if the SYCL user buffer of this buffer or of a buffer
+      containing it has been destroyed */
+  bool is_released() const {
+    return released || (parent && parent->is_released());
+  }
+
+
+  /** Give some fresh storage to the buffer, without any copy
+
+      \return the previous storage to keep alive while it is still used
+      by some tasks, or an empty pointer if the buffer cannot be renamed
+  */
+  virtual std::shared_ptr<void> rename() { return {}; }
+
+
+  /// Wait for the tasks using this very buffer to release it
+  void wait_for_users() {
+    detail::wait_until(number_of_users, waiters, [] (std::size_t users) {
+        // When there is no producer for this buffer, we are ready to use it
+        return users == 0;
+      });
   }
 
 
@@ -186,8 +495,14 @@ struct buffer_base : public std::enable_shared_from_this<buffer_base> {
 
   /** Transfer the most up-to-date version of the data to the host
       if the host version is not already up-to-date
+
+      If only the \p length bytes starting at \p offset are
+      transferred, the host is still not considered as up-to-date
   */
-  void sync_with_host(std::size_t size, void* data) {
+  void sync_with_host(std::size_t size, void* data,
+                      std::size_t offset = 0,
+                      std::size_t length =
+                        std::numeric_limits<std::size_t>::max()) {
     trisycl::context host_context;
     if (!is_data_up_to_date(host_context) && !fresh_ctx.empty()) {
       /* We know that the context(s) in \c fresh_ctx hold the most recent
@@ -195,8 +510,13 @@ struct buffer_base : public std::enable_shared_from_this<buffer_base> {
       */
       auto fresh_context = *(fresh_ctx.begin());
       auto fresh_q = fresh_context.get_boost_queue();
-      fresh_q.enqueue_read_buffer(buffer_cache[fresh_context], 0, size, data);
-      fresh_ctx.insert(host_context);
+      if (offset == 0 && length >= size) {
+        fresh_q.enqueue_read_buffer(buffer_cache[fresh_context], 0, size, data);
+        fresh_ctx.insert(host_context);
+      }
+      else
+        fresh_q.enqueue_read_buffer(buffer_cache[fresh_context], offset, length,
+                                    static_cast<char*>(data) + offset);
     }
   }
 
@@ -204,9 +524,15 @@ struct buffer_base : public std::enable_shared_from_this<buffer_base> {
   /** When a transfer is requested this function is called, it will
       update the state of the buffer according to the context in which
       the accessor is created and the access mode
+
+      A read accessor to a region of the buffer only requires the \p
+      length bytes starting at \p offset to be transferred
   */
   void update_buffer_state(const trisycl::context& target_ctx,
-                           access::mode mode, std::size_t size, void* data) {
+                           access::mode mode, std::size_t size, void* data,
+                           std::size_t offset = 0,
+                           std::size_t length =
+                        std::numeric_limits<std::size_t>::max()) {
     /* The \c cl_buffer we put in the cache might get accessed again in the
        future, this means that we have to always to create it in read/write
        mode to be able to write to it if it is accessed through a
@@ -214,6 +540,26 @@ struct buffer_base : public std::enable_shared_from_this<buffer_base> {
      */
     auto constexpr flag = CL_MEM_READ_WRITE;
 
+    /* Only a part of the buffer is read. Since the freshness is
+       tracked for the whole buffer, transfer only this part but do
+       not consider the target context as up-to-date afterwards. A
+       partial write falls back to a whole transfer below, because the
+       rest of the buffer would not be fresh in the target context
+     */
+    if (mode == access::mode::read && (offset != 0 || length < size)) {
+      if (is_data_up_to_date(target_ctx))
+        return;
+      sync_with_host(size, data, offset, length);
+      if (!target_ctx.is_host()) {
+        if (!is_cached(target_ctx))
+          create_in_cache(target_ctx, size, flag, 0);
+        auto q = target_ctx.get_boost_queue();
+        q.enqueue_write_buffer(buffer_cache[target_ctx], offset, length,
+                               static_cast<char*>(data) + offset);
+      }
+      return;
+    }
+
     /* The buffer is accessed in read mode, we want to transfer the data only if
        necessary. We start a transfer if the data on the target context is not
        up to date and then update the fresh context set.
@@ -317,6 +663,27 @@ struct buffer_base : public std::enable_shared_from_this<buffer_base> {
 
 };
 
+
+/** An awaitable to suspend a coroutine until a buffer is no longer
+    used by any kernel
+
+    The coroutine is resumed by a worker of the executor.
+*/
+struct buffer_awaiter {
+  /// The buffer to wait for
+  std::shared_ptr<buffer_base> b;
+
+  bool await_ready() const noexcept {
+    return b->number_of_users == 0;
+  }
+
+  bool await_suspend(std::coroutine_handle<> h) {
+    return b->add_continuation([h] { h.resume(); });
+  }
+
+  void await_resume() const noexcept {}
+};
+
 /// @} End the data Doxygen group
 
 }
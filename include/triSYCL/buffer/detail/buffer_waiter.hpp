@@ -46,14 +46,30 @@ public:
   // Make the implementation member directly accessible in this class
   using implementation_t::implementation;
 
-  /// Create a new buffer_waiter on top of a detail::buffer
-  buffer_waiter(detail::buffer<T, Dimensions> *b) : implementation_t { b } {}
+  /** Create a new buffer_waiter on top of a detail::buffer
+
+      \param[in] detached is true if the destruction does not wait
+      for the buffer
+  */
+  buffer_waiter(detail::buffer<T, Dimensions> *b, bool detached = false)
+    : implementation_t { b }
+    , detached { detached } {}
 
 
   /** The buffer_waiter destructor waits for any data to be written
-      back to the host, if any
+      back to the host, if any, unless it is detached
   */
   ~buffer_waiter() {
+    if (implementation->is_recorded()) {
+      /* Some command graph keeps the implementation alive, so waiting
+         for its destruction could dead-lock */
+      implementation->release(!detached);
+      return;
+    }
+    if (detached)
+      /* Just release the implementation. The last kernel using it
+         destroys it and does the write-back */
+      return;
     /* Get a future from the implementation if we have to wait for its
        destruction */
     auto f = implementation->get_destructor_future();
@@ -67,6 +83,11 @@ public:
       TRISYCL_DUMP_T("~buffer_waiter() is done");
     }
   }
+
+private:
+
+  /// Do not wait for the buffer on destruction
+  bool detached;
 };
 
 
@@ -74,8 +95,8 @@ public:
 template <typename T,
           int Dimensions = 1,
           typename Allocator = buffer_allocator<std::remove_const_t<T>>>
-inline auto waiter(detail::buffer<T, Dimensions> *b) {
-  return new buffer_waiter<T, Dimensions, Allocator> { b };
+inline auto waiter(detail::buffer<T, Dimensions> *b, bool detached = false) {
+  return new buffer_waiter<T, Dimensions, Allocator> { b, detached };
 }
 
 /// @} End the data Doxygen group
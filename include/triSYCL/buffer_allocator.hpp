@@ -12,6 +12,8 @@
 #include <cstddef>
 #include <memory>
 
+#include "triSYCL/detail/size_class_pool.hpp"
+
 namespace trisycl {
 
 /** \addtogroup data Data access and storage in SYCL
@@ -26,6 +28,19 @@ namespace trisycl {
 template <typename T>
 using buffer_allocator = std::allocator<T>;
 
+
+/** A buffer allocator recycling the memory of the destroyed buffers
+    for the next buffers of a similar size
+
+    This avoids the cost of the system allocation and of the first
+    touch page faults when some buffers are created and destroyed in a
+    loop.
+
+    This is a triSYCL extension.
+*/
+template <typename T>
+using pooled_buffer_allocator = detail::size_class_allocator<T>;
+
 /// @} End the data Doxygen group
 
 }
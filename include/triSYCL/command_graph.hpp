@@ -0,0 +1,127 @@
+#ifndef TRISYCL_SYCL_COMMAND_GRAPH_HPP
+#define TRISYCL_SYCL_COMMAND_GRAPH_HPP
+
+/** \file A sequence of command groups recorded from a queue to be
+    replayed with a low overhead
+
+    This is a triSYCL extension.
+
+    This file is distributed under the University of Illinois Open Source
+    License. See LICENSE.TXT for details.
+*/
+
+#include <cstddef>
+#include <memory>
+
+#include "triSYCL/command_graph/detail/command_graph.hpp"
+#include "triSYCL/detail/shared_ptr_implementation.hpp"
+#include "triSYCL/event.hpp"
+
+namespace trisycl {
+
+/** \addtogroup execution Platforms, contexts, devices and queues
+    @{
+*/
+
+/** A command graph recorded from the command groups submitted to a
+    queue between \c queue::begin_recording() and \c
+    queue::end_recording()
+
+    Replaying the graph executes all the recorded kernels in
+    submission order with a single task, without constructing any
+    handler or accessor and registering the buffers only once.
+
+    The kernels are replayed with the same accessors and ranges. Once
+    a buffer used by the graph is destroyed, its data are written back
+    without waiting for the graph and the graph cannot be replayed
+    anymore.
+
+    Since the dependencies on events cannot be replayed, \c
+    handler::depends_on() throws during the recording.
+
+    This is a triSYCL extension
+*/
+class command_graph
+  : public detail::shared_ptr_implementation<command_graph,
+                                             detail::command_graph> {
+
+  // The type encapsulating the implementation
+  using implementation_t = typename command_graph::shared_ptr_implementation;
+
+  // Allows the comparison operation to access the implementation
+  friend implementation_t;
+
+public:
+
+  // Make the implementation member directly accessible in this class
+  using implementation_t::implementation;
+
+
+  /// Construct a command graph from its implementation
+  command_graph(std::shared_ptr<detail::command_graph> g)
+    : implementation_t { std::move(g) } {}
+
+
+  /// Return the number of recorded command groups
+  std::size_t size() const {
+    return implementation->nodes.size();
+  }
+
+
+  /** Fuse the consecutive range kernels with the same iteration space
+      into a single sweep over the iteration space
+
+      This is only valid if these kernels access the buffers they
+      share elementwise, that is an element written by a kernel at a
+      given index is only read by the next kernels at the same index.
+
+      Only the graphs recorded with \c queue::begin_recording(true)
+      or \c queue::start_fusion() have kernels which can be fused.
+  */
+  void fuse() {
+    implementation->fuse();
+  }
+
+
+  /** Replay all the recorded command groups on the queue they were
+      recorded from
+
+      \throw invalid_object_error if a buffer used by the graph has
+      been destroyed
+
+      \return an event to track the execution of the whole graph
+  */
+  event replay() {
+    return { implementation->replay(implementation) };
+  }
+};
+
+/// @} End the execution Doxygen group
+
+}
+
+/* Inject a custom specialization of std::hash to have the command
+   graph usable into an unordered associative container
+*/
+namespace std {
+
+template <> struct hash<trisycl::command_graph> {
+
+  auto operator()(const trisycl::command_graph &g) const {
+    // Forward the hashing to the implementation
+    return g.hash();
+  }
+
+};
+
+}
+
+/*
+    # Some Emacs stuff:
+    ### Local Variables:
+    ### ispell-local-dictionary: "american"
+    ### eval: (flyspell-prog-mode)
+    ### End:
+*/
+
+#endif // TRISYCL_SYCL_COMMAND_GRAPH_HPP
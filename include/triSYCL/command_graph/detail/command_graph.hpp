@@ -0,0 +1,226 @@
+#ifndef TRISYCL_SYCL_COMMAND_GRAPH_DETAIL_COMMAND_GRAPH_HPP
+#define TRISYCL_SYCL_COMMAND_GRAPH_DETAIL_COMMAND_GRAPH_HPP
+
+/** \file The recorded sequence of command groups behind a command graph
+
+    This file is distributed under the University of Illinois Open Source
+    License. See LICENSE.TXT for details.
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "triSYCL/buffer/detail/buffer_base.hpp"
+#include "triSYCL/command_group/detail/task.hpp"
+#include "triSYCL/detail/debug.hpp"
+#include "triSYCL/exception.hpp"
+#include "triSYCL/parallelism/detail/parallelism.hpp"
+#include "triSYCL/queue/detail/queue.hpp"
+
+namespace trisycl::detail {
+
+/** \addtogroup execution Platforms, contexts, devices and queues
+    @{
+*/
+
+/** A sequence of command groups recorded once from a queue to be
+    replayed many times
+
+    Since the command groups are recorded in submission order, this
+    order is already a topological order of their dependencies and
+    the graph is flattened into a list of nodes executed in sequence
+    by a single task.
+*/
+struct command_graph : detail::debug<detail::command_graph> {
+
+  /// What is needed to execute a recorded command group
+  struct node {
+    /// The prologues to execute before the kernel
+    decltype(detail::task::prologues) prologues;
+
+    /// The kernel itself
+    detail::task::kernel_function kernel;
+
+    /// The epilogues to execute after the kernel
+    decltype(detail::task::epilogues) epilogues;
+
+    /// The extents of the iteration space of a fusable kernel
+    std::vector<std::size_t> fusable_extents;
+
+    /// The kernel executing a chunk of its iteration space, if fusable
+    std::function<void(std::size_t, std::size_t)> fusable_kernel;
+
+    /// Create a node with only a kernel
+    static node of_kernel(detail::task::kernel_function k) {
+      node n;
+      n.kernel = std::move(k);
+      return n;
+    }
+
+    /// Test if the node can be fused with a node of the same extents
+    bool is_fusable() const {
+      return fusable_kernel && prologues.empty() && epilogues.empty();
+    }
+  };
+
+  /** Number of iterations of a fused sweep executed by all the kernels
+      before going to the next chunk
+
+      It should be small enough for the data of all the kernels to
+      stay in the cache and large enough to amortize the switch
+      between kernels.
+  */
+  static constexpr std::size_t fusion_chunk_size = 1024;
+
+  /// The queue the command groups were recorded from and replayed on
+  std::shared_ptr<detail::queue> owner_queue;
+
+  /// The recorded kernels in submission order
+  std::vector<node> nodes;
+
+  /** The union of the buffer accesses of all the nodes, with whether
+      the buffer is written by some node
+
+      These buffers are marked as recorded up to the graph destruction.
+  */
+  std::vector<std::pair<std::shared_ptr<detail::buffer_base>, bool>> accesses;
+
+
+  /// Create an empty graph to record the command groups of a queue
+  command_graph(const std::shared_ptr<detail::queue> &q)
+    : owner_queue { q } {}
+
+
+  command_graph(const command_graph &) = delete;
+  command_graph &operator=(const command_graph &) = delete;
+
+
+  /// Allow again the renaming of the buffers not used by other graphs
+  ~command_graph() {
+    for (auto &[b, is_write_mode] : accesses)
+      b->unrecord();
+  }
+
+
+  /** Record the command group of a task
+
+      The task is only used to collect the command group and is never
+      executed by itself.
+  */
+  void record(detail::task &t) {
+    if (!t.is_scheduled())
+      // Nothing to execute without any kernel
+      return;
+    nodes.push_back({ .prologues = std::move(t.prologues),
+                      .kernel = std::move(t.execution),
+                      .epilogues = std::move(t.epilogues),
+                      .fusable_extents = std::move(t.fusable_extents),
+                      .fusable_kernel = std::move(t.fusable_kernel) });
+    for (auto &[b, is_write_mode] : t.recorded_accesses) {
+      auto a = std::ranges::find(accesses, b,
+                                 &decltype(accesses)::value_type::first);
+      if (a == accesses.end()) {
+        /* The accessors of the kernels keep pointing to the current
+           storage of the buffer, so it cannot be renamed while the
+           graph exists */
+        b->record();
+        accesses.emplace_back(b, is_write_mode);
+      }
+      else
+        a->second = a->second || is_write_mode;
+    }
+  }
+
+
+  /** Fuse the consecutive range kernels with the same iteration space
+      into a single sweep
+
+      The kernels of the graph are assumed to access the buffers they
+      share elementwise, so that the element written by a kernel at
+      some index is only read by the next kernels at the same index.
+
+      Only the kernels recorded with a fusable version, as requested
+      by \c queue::begin_recording(true), can be fused.
+  */
+  void fuse() {
+    std::vector<node> fused;
+    for (auto first = nodes.begin(); first != nodes.end();) {
+      auto last = first + 1;
+      if (first->is_fusable())
+        while (last != nodes.end() && last->is_fusable()
+               && last->fusable_extents == first->fusable_extents)
+          ++last;
+      if (last - first == 1) {
+        fused.push_back(std::move(*first));
+        first = last;
+        continue;
+      }
+      std::size_t count = 1;
+      for (auto e : first->fusable_extents)
+        count *= e;
+      TRISYCL_DUMP_T("Fuse " << last - first << " kernels");
+      std::vector<std::function<void(std::size_t, std::size_t)>> kernels;
+      for (; first != last; ++first)
+        kernels.push_back(std::move(first->fusable_kernel));
+      fused.push_back(node::of_kernel([kernels = std::move(kernels), count] {
+          detail::parallel_for_fused(count, kernels, fusion_chunk_size);
+        }));
+    }
+    nodes = std::move(fused);
+  }
+
+
+  /// Execute all the nodes in sequence
+  void execute() const {
+    for (const auto &n : nodes) {
+      for (const auto &p : n.prologues)
+        p();
+      n.kernel();
+      for (const auto &e : n.epilogues)
+        e();
+    }
+  }
+
+
+  /** Replay the recorded command groups as a single task
+
+      \throw invalid_object_error if the SYCL buffer of some recorded
+      access has been destroyed
+
+      \return the task to track the execution
+  */
+  std::shared_ptr<detail::task>
+  replay(const std::shared_ptr<command_graph> &self) {
+    for (auto &[b, is_write_mode] : accesses)
+      if (b->is_released())
+        throw invalid_object_error {
+          "A buffer used by the command graph has been destroyed" };
+    auto t = detail::task::create(owner_queue);
+    // Even if the queue is recording another graph, this is for real
+    t->recording = false;
+    for (auto &[b, is_write_mode] : accesses)
+      t->add_buffer(b, is_write_mode);
+    t->schedule([self] { self->execute(); });
+    TRISYCL_DUMP_T("Replay command graph " << this << " with "
+                   << nodes.size() << " nodes");
+    return t;
+  }
+};
+
+/// @} End the execution Doxygen group
+
+}
+
+/*
+    # Some Emacs stuff:
+    ### Local Variables:
+    ### ispell-local-dictionary: "american"
+    ### eval: (flyspell-prog-mode)
+    ### End:
+*/
+
+#endif // TRISYCL_SYCL_COMMAND_GRAPH_DETAIL_COMMAND_GRAPH_HPP
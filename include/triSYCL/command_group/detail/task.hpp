@@ -9,10 +9,13 @@
     License. See LICENSE.TXT for details.
 */
 
-#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <mutex>
-#include <thread>
+#include <utility>
 #include <vector>
 
 #ifdef TRISYCL_OPENCL
@@ -21,7 +24,11 @@
 
 #include "triSYCL/accessor/detail/accessor_base.hpp"
 #include "triSYCL/buffer/detail/buffer_base.hpp"
+#include "triSYCL/detail/atomic_wait.hpp"
 #include "triSYCL/detail/debug.hpp"
+#include "triSYCL/detail/small_function.hpp"
+#include "triSYCL/detail/small_vector.hpp"
+#include "triSYCL/detail/trace.hpp"
 #include "triSYCL/kernel.hpp"
 #include "triSYCL/queue/detail/queue.hpp"
 
@@ -40,25 +47,108 @@ struct task : public std::enable_shared_from_this<task>,
       \todo Use a set to check that some buffers are not used many
       times at least on writing
   */
-  std::vector<std::shared_ptr<detail::buffer_base>> buffers_in_use;
+  detail::small_vector<std::shared_ptr<detail::buffer_base>, 4>
+  buffers_in_use;
 
-  /// The tasks producing the buffers used by this task
-  std::vector<std::shared_ptr<detail::task>> producer_tasks;
+  /** The tasks to be notified when this task completes
+
+      Protected by \c successors_mutex */
+  detail::small_vector<std::shared_ptr<detail::task>, 4> successors;
+
+  /** The continuations, such as suspended coroutines, to execute
+      when this task completes
+
+      Protected by \c successors_mutex */
+  detail::small_vector<detail::executor::work, 1> continuations;
+
+  /** Number of producer tasks not completed yet
+
+      It starts at 1 as a guard so that the task cannot be started
+      while the command group is still building the dependencies, the
+      guard being released by \c schedule()
+  */
+  std::atomic<std::size_t> unmet_dependencies { 1 };
+
+  /** The type-erased kernel, with room for the closure of a kernel
+      capturing a few accessors */
+  using kernel_function = detail::small_function<void(void), 128>;
+
+  /** The type-erased prologues and epilogues, with room for the
+      closure of an event or an accessor */
+  using hook_function = detail::small_function<void(void)>;
+
+  /// The kernel to execute when all the producers are completed
+  kernel_function execution;
+
+  /** The rest of a kernel which has yielded to some more urgent work,
+      set by the kernel itself to be executed later */
+  kernel_function resumption;
+
+  /** The task is only recording a command group into a command graph
+      and will not be executed by itself */
+  bool recording;
+
+  /** The buffers used by a recording task, with whether they are
+      written */
+  std::vector<std::pair<std::shared_ptr<detail::buffer_base>, bool>>
+  recorded_accesses;
+
+  /** The extents of the iteration space of a recorded range kernel
+      which can be fused with other kernels */
+  std::vector<std::size_t> fusable_extents;
+
+  /** The recorded range kernel executing a [begin, end) chunk of its
+      linearized iteration space, if it can be fused */
+  std::function<void(std::size_t, std::size_t)> fusable_kernel;
+
+  /** Some resources to release only at the end of the task, such as
+      a previous version of a renamed buffer used by the kernel
+
+      Protected by \c successors_mutex */
+  detail::small_vector<std::shared_ptr<void>, 2> kept_alive;
 
   /// Keep track of any prologue to be executed before the kernel
-  std::vector<std::function<void(void)>> prologues;
+  detail::small_vector<hook_function, 2> prologues;
 
   /// Keep track of any epilogue to be executed after the kernel
-  std::vector<std::function<void(void)>> epilogues;
+  detail::small_vector<hook_function, 2> epilogues;
+
+  /** Store if the execution ended, to be waited on by \c wait()
+
+      It is only set with \c successors_mutex taken, so that no
+      successor can be added once the task has completed */
+  std::atomic<bool> execution_ended = false;
+
+  /// Number of threads waiting for the completion of the task
+  std::atomic<std::size_t> waiters = 0;
+
+  /// Store if a kernel has been submitted by the command group
+  bool scheduled = false;
+
+  /// Store if the execution started, to report the task status
+  std::atomic<bool> execution_started = false;
 
-  /// Store if the execution ended, to be notified by task_ready
-  bool execution_ended = false;
+  /** The tasks this task depends on, to report the event wait list
 
-  /// To signal when this task is ready
-  std::condition_variable ready;
+      Only modified while the command group is built */
+  detail::small_vector<std::weak_ptr<detail::task>, 4> predecessors;
 
-  /// To protect the access to the condition variable
-  std::mutex ready_mutex;
+  /// Record the timestamps of the execution if the queue asks for it
+  bool profiling;
+
+  /// The serial number of the task in the trace, 0 if not traced
+  std::uint64_t trace_id = detail::tracer::get().new_task();
+
+  /// The mangled name of the kernel for the trace, with static storage
+  const char *trace_name = nullptr;
+
+  /// The timestamps in nanoseconds of the submission, start and end
+  std::uint64_t submit_time = 0;
+  std::uint64_t start_time = 0;
+  std::uint64_t end_time = 0;
+
+  /// To protect the successors and the completion of the task
+  std::mutex successors_mutex;
 
   /** Keep track of the queue used to submission to notify kernel completion
       or to run OpenCL kernels on */
@@ -71,90 +161,215 @@ struct task : public std::enable_shared_from_this<task>,
 
       This is used to relate a kernel parameter of a kernel generated
       by the device compiler to its accessor. */
-  std::vector<std::weak_ptr<detail::accessor_base>> accessors;
+  detail::small_vector<std::weak_ptr<detail::accessor_base>, 4> accessors;
 
 
   /// Create a task from a submitting queue
   task(const std::shared_ptr<detail::queue> &q)
-    : owner_queue { q } {}
+    : recording { q->is_recording() }
+    , profiling { q->is_profiling_enabled() }
+    , owner_queue { q } {}
 
 
-  /// Add a new task to the task graph and schedule for execution
-  void schedule(std::function<void(void)> f) {
-    /* To keep a copy of the task shared_ptr after the end of the
-       command group, capture it by copy in the following lambda.
-    */
-    auto execution = [f = std::move(f), task = shared_from_this()] {
-      // Wait for the required tasks to be ready
-      task->wait_for_producers();
-      task->prelude();
-      TRISYCL_DUMP_T("Execute the kernel");
-      // Execute the kernel
-      f();
-      task->postlude();
-      // Release the buffers that have been written by this task
-      task->release_buffers();
-      // Notify the waiting tasks that we are done
-      task->notify_consumers();
-      // Notify the queue we are done
-      task->owner_queue->kernel_end();
-      TRISYCL_DUMP_T("Task thread exit");
-    };
+  /** Create a task from a submitting queue
+
+      The task and its control block are allocated together from the
+      memory recycled from the completed tasks of the queue.
+  */
+  static std::shared_ptr<task> create(const std::shared_ptr<detail::queue> &q) {
+    return std::allocate_shared<task>(q->get_task_allocator(), q);
+  }
+
+
+  /// Return the current timestamp in nanoseconds for profiling
+  static std::uint64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+
+  /** Add a new task to the task graph and schedule for execution
+
+      The task is submitted for execution by its queue only when all its
+      producers are completed, so no thread is blocked waiting for
+      them.
+  */
+  void schedule(kernel_function f) {
+    if (recording) {
+      // Just keep the kernel for the command graph
+      scheduled = true;
+      execution = std::move(f);
+      return;
+    }
+    if (profiling)
+      submit_time = now();
+    detail::tracer::get().record(detail::trace_kind::submit, trace_id, 0,
+                                 trace_name);
+    scheduled = true;
+    execution = std::move(f);
     /* Notify the queue that there is a kernel submitted to the
        queue. Do not do it in the task contructor so that we can deal
        with command group without kernel and if we put it inside the
-       thread, the queue may have finished before the thread is
+       executor, the queue may have finished before the task is
        scheduled */
     owner_queue->kernel_start();
-    /* \todo it may be implementable with packaged_task that would
-       deal with exceptions in kernels
-    */
 #ifndef TRISYCL_NO_ASYNC
-    /* If in asynchronous execution mode, execute the functor in a new
-       thread */
-    std::thread thread(execution);
-    TRISYCL_DUMP_T("Task thread started");
-    /** Detach the thread since it will synchronize by its own means
-
-        \todo This is an issue if there is an exception in the kernel
-    */
-    thread.detach();
+    if (owner_queue->is_in_order())
+      // Just run after the previous command group of the queue
+      if (auto previous = owner_queue->set_last_task(shared_from_this()))
+        add_producer(previous);
+    /* The dependency graph of the task is complete, so release the
+       guard which may make the task ready to run */
+    release_dependency();
 #else
-    // Just a synchronous execution otherwise
-    execution();
+    /* Just a synchronous execution otherwise, since all the producers
+       have already been executed */
+    run();
 #endif
   }
 
 
-  /// Wait for the required producer tasks to be ready
-  void wait_for_producers() {
-    TRISYCL_DUMP_T("Task " << this << " waits for the producer tasks");
-    for (auto &t : producer_tasks)
-      t->wait();
-    // We can let the producers rest in peace
-    producer_tasks.clear();
+  /** Notify the task that one of its dependencies is satisfied
+
+      When the last one is, submit the task for execution by its queue.
+  */
+  void release_dependency() {
+    if (--unmet_dependencies == 0) {
+      detail::tracer::get().record(detail::trace_kind::ready, trace_id);
+      /* To keep a copy of the task shared_ptr until the end of the
+         execution, capture it by copy in the following lambda.
+
+         \todo This is an issue if there is an exception in the kernel
+      */
+      owner_queue->dispatch([task = shared_from_this()] {
+        task->run();
+      });
+      TRISYCL_DUMP_T("Task " << this << " submitted for execution");
+    }
+  }
+
+
+  /// Execute the task when all its producers are completed
+  void run() {
+    if (profiling)
+      start_time = now();
+    execution_started = true;
+    detail::tracer::get().record(detail::trace_kind::start, trace_id);
+    prelude();
+    TRISYCL_DUMP_T("Execute the kernel");
+    /* Move the kernel out of the task so that what it captures,
+       including some accessors referring to this task, is released
+       just after the execution */
+    execute(std::move(execution));
+  }
+
+
+  /** Execute the kernel or the rest of a kernel which has yielded,
+      then complete the task unless the kernel has yielded again
+
+      A kernel which has yielded is resumed by a worker like any
+      other ready work of the queue priority, so the more urgent work
+      is run by the workers instead of on the stack of the kernel.
+  */
+  void execute(kernel_function f) {
+    f();
+    f = nullptr;
+    if (resumption) {
+      TRISYCL_DUMP_T("The kernel of task " << this << " yields");
+      detail::executor::instance()->submit([task = shared_from_this()] {
+          task->execute(std::exchange(task->resumption, nullptr));
+        }, owner_queue->get_priority());
+      return;
+    }
+    postlude();
+    if (profiling)
+      // Record it before notifying the waiters, which may read it
+      end_time = now();
+    detail::tracer::get().record(detail::trace_kind::end, trace_id);
+    // Release the buffers that have been written by this task
+    release_buffers();
+    // Notify the waiting tasks that we are done
+    notify_consumers();
+    // Notify the queue we are done
+    owner_queue->kernel_end();
+    TRISYCL_DUMP_T("Task execution end");
+  }
+
+
+  /** Register a task to be notified when this task completes
+
+      \return false if this task has already completed, so there is
+      nothing to wait for
+  */
+  bool add_successor(std::shared_ptr<detail::task> consumer) {
+    std::lock_guard<std::mutex> lg { successors_mutex };
+    if (execution_ended)
+      return false;
+    successors.push_back(std::move(consumer));
+    return true;
+  }
+
+
+  /// Make this task depend on the completion of a producer task
+  void add_producer(const std::shared_ptr<detail::task> &producer) {
+    predecessors.push_back(producer);
+    detail::tracer::get().record(detail::trace_kind::dependency, trace_id,
+                                 producer->trace_id);
+    ++unmet_dependencies;
+    if (!producer->add_successor(shared_from_this()))
+      // The producer has already completed
+      --unmet_dependencies;
   }
 
 
   /// Release the buffers that have  been used by this task
   void release_buffers() {
     TRISYCL_DUMP_T("Task " << this << " releases the written buffers");
-    for (auto b: buffers_in_use)
+    for (auto &b: buffers_in_use)
       b->release();
     buffers_in_use.clear();
   }
 
 
-  /// Notify the waiting tasks that we are done
+  /** Notify the waiting tasks that we are done
+
+      The successors whose last dependency was this task are submitted
+      for execution.
+  */
   void notify_consumers() {
     TRISYCL_DUMP_T("Notify all the task waiting for this task " << this);
-   {
-     std::unique_lock<std::mutex> ul { ready_mutex };
-     execution_ended = true;
-   }
-    /* \todo Verify that the memory model with the notify does not
-       require some fence or atomic */
-    ready.notify_all();
+    decltype(successors) to_notify;
+    decltype(continuations) to_resume;
+    // Release the kept resources outside of the lock
+    decltype(kept_alive) to_release;
+    {
+      std::lock_guard<std::mutex> lg { successors_mutex };
+      execution_ended = true;
+      to_notify.swap(successors);
+      to_resume.swap(continuations);
+      to_release.swap(kept_alive);
+    }
+    detail::notify_waiters(execution_ended, waiters);
+    for (auto &t : to_notify)
+      t->release_dependency();
+    for (auto &c : to_resume)
+      detail::executor::instance()->submit(std::move(c),
+                                           owner_queue->get_priority());
+  }
+
+
+  /** Register a continuation to execute by the executor when this
+      task completes, for example to resume a coroutine awaiting it
+
+      \return false if this task has already completed, so the
+      continuation has not been registered
+  */
+  bool add_continuation(detail::executor::work c) {
+    std::lock_guard<std::mutex> lg { successors_mutex };
+    if (execution_ended)
+      return false;
+    continuations.push_back(std::move(c));
+    return true;
   }
 
 
@@ -164,43 +379,87 @@ struct task : public std::enable_shared_from_this<task>,
   */
   void wait() {
     TRISYCL_DUMP_T("The task wait for task " << this << " to end");
-    std::unique_lock<std::mutex> ul { ready_mutex };
-    ready.wait(ul, [&] { return execution_ended; });
+    detail::wait_until(execution_ended, waiters, [] (bool ended) {
+      return ended;
+    });
+  }
+
+
+  /// Test if the execution of the task has started
+  bool is_started() const {
+    return execution_started;
+  }
+
+
+  /// Test if the execution of the task has completed
+  bool is_completed() const {
+    return execution_ended;
+  }
+
+
+  /** Keep a resource alive up to the end of the task execution
+
+      \return false if the task has already completed, so the resource
+      is not needed
+  */
+  bool keep_alive(std::shared_ptr<void> resource) {
+    std::lock_guard<std::mutex> lg { successors_mutex };
+    if (execution_ended)
+      return false;
+    kept_alive.push_back(std::move(resource));
+    return true;
   }
 
 
-  /** Register a buffer to this task
+  /** Test if another task is from the same in-order queue
+
+      In that case it is already ordered before this task and there is
+      no need for an edge in the dependency graph.
+  */
+  bool in_same_in_order_queue(const detail::task &t) const {
+    return owner_queue->is_in_order() && t.owner_queue == owner_queue;
+  }
+
+
+  /** Register a buffer to this task, accessing only the region \p r
+      of the buffer
 
       This is how the dependency graph is incrementally built.
   */
   void add_buffer(std::shared_ptr<detail::buffer_base> &buf,
-                  bool is_write_mode) {
+                  bool is_write_mode,
+                  bool is_discard_mode = false,
+                  const buffer_region &r = {}) {
     TRISYCL_DUMP_T("Add buffer " << buf << " in task " << this);
+    if (recording) {
+      /* The buffer will be registered by the command graph replay,
+         so do not interfere with the current buffer users */
+      recorded_accesses.emplace_back(buf, is_write_mode);
+      return;
+    }
     /* Keep track of the use of the buffer to notify its release at
        the end of the execution */
     buffers_in_use.push_back(buf);
+    detail::tracer::get().record(detail::trace_kind::access, trace_id,
+                                 reinterpret_cast<std::uintptr_t>(buf.get()),
+                                 is_write_mode ? "write" : "read");
     // To be sure the buffer does not disappear before the kernel can run
     buf->use();
 
-    std::shared_ptr<detail::task> latest_producer;
-    if (is_write_mode) {
-      /* Set this task as the latest producer of the buffer so that
-         another kernel may wait on this task */
-      latest_producer = buf->set_latest_producer(shared_from_this());
-    }
-    else
-      latest_producer = buf->get_latest_producer();
+    /* Depend on the tasks which have to access the buffer before
+       this one, so that independent readers can run concurrently
 
-    /* If the buffer is to be produced by a task, add the task in the
-       producer list to wait on it before running the task core
-
-       If a buffer is accessed first in write mode and then in read mode,
-       the task will add itself as a producer and will wait for itself
-       when calling \c wait_for_producers, we avoid this by checking that
-       \c latest_producer is not \c this
+       If a buffer is accessed several times by the same task, for
+       example first in write mode and then in read mode, the task
+       would depend on itself and never run, we avoid this by checking
+       that the dependency is not \c this
     */
-    if (latest_producer && latest_producer != shared_from_this())
-      producer_tasks.push_back(latest_producer);
+    for (auto &t : buf->register_access(shared_from_this(),
+                                           is_write_mode,
+                                           is_discard_mode,
+                                           r))
+      if (t != shared_from_this() && !in_same_in_order_queue(*t))
+        add_producer(t);
   }
 
 
@@ -227,16 +486,22 @@ struct task : public std::enable_shared_from_this<task>,
 
 
   /// Add a function to the prelude to run before kernel execution
-  void add_prelude(const std::function<void(void)> &f) {
+  void add_prelude(hook_function f) {
     TRISYCL_DUMP_T("task::add_prelude");
 
-    prologues.push_back(f);
+    prologues.push_back(std::move(f));
   }
 
 
   /// Add a function to the postlude to run after kernel execution
-  void add_postlude(const std::function<void(void)> &f) {
-    epilogues.push_back(f);
+  void add_postlude(hook_function f) {
+    epilogues.push_back(std::move(f));
+  }
+
+
+  /// Test if a kernel has been scheduled for execution by this task
+  bool is_scheduled() const {
+    return scheduled;
   }
 
 
@@ -308,6 +573,36 @@ std::size_t register_accessor(std::weak_ptr<detail::accessor_base> a) {
 
 };
 
+
+/** Test if a task has completed
+
+    This is a proxy function to avoid complicated type recursion.
+*/
+inline static bool task_is_completed(const std::shared_ptr<detail::task> &t) {
+  return t->is_completed();
+}
+
+
+/** Keep a resource alive up to the end of a task
+
+    This is a proxy function to avoid complicated type recursion.
+*/
+inline static bool task_keep_alive(const std::shared_ptr<detail::task> &t,
+                                   std::shared_ptr<void> resource) {
+  return t->keep_alive(std::move(resource));
+}
+
+
+/** Test if another task is from the same in-order queue as a task
+
+    This is a proxy function to avoid complicated type recursion.
+*/
+inline static bool
+task_in_same_in_order_queue(const std::shared_ptr<detail::task> &t,
+                            const std::shared_ptr<detail::task> &other) {
+  return t->in_same_in_order_queue(*other);
+}
+
 }
 
 /*
@@ -0,0 +1,107 @@
+#ifndef TRISYCL_SYCL_DETAIL_ALIGNED_ALLOCATOR_HPP
+#define TRISYCL_SYCL_DETAIL_ALIGNED_ALLOCATOR_HPP
+
+/** \file An allocator with a run-time alignment, optionally backed by
+    huge pages
+
+    This file is distributed under the University of Illinois Open Source
+    License. See LICENSE.TXT for details.
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+
+#if __has_include(<sys/mman.h>)
+#include <sys/mman.h>
+#endif
+
+namespace trisycl::detail {
+
+/** \addtogroup helpers Some helpers for the implementation
+    @{
+*/
+
+/** A standard allocator aligning the memory on a run-time alignment
+
+    With huge pages, an allocation of at least a huge page is aligned
+    on a huge page and the system is asked to back it with transparent
+    huge pages, when it is possible.
+*/
+template <typename T>
+struct aligned_allocator {
+  using value_type = T;
+
+  /// The size of a transparent huge page on the common systems
+  static constexpr std::size_t huge_page_size = std::size_t { 2 } << 20;
+
+  /// The requested alignment in bytes, a power of 2
+  std::size_t alignment = alignof(T);
+
+  /// Use huge pages for the large allocations
+  bool huge_pages = false;
+
+
+  aligned_allocator(std::size_t alignment, bool huge_pages = false)
+    : alignment { alignment }
+    , huge_pages { huge_pages } {}
+
+
+  /// Rebind from an allocator of another type
+  template <typename U>
+  aligned_allocator(const aligned_allocator<U> &other)
+    : alignment { other.alignment }
+    , huge_pages { other.huge_pages } {}
+
+
+  T *allocate(std::size_t n) {
+    auto size = n*sizeof(T);
+    auto p = ::operator new(size, std::align_val_t { alignment_for(size) });
+#ifdef MADV_HUGEPAGE
+    if (use_huge_pages(size))
+      // Only a hint, so the result is ignored
+      ::madvise(p, size - size % huge_page_size, MADV_HUGEPAGE);
+#endif
+    return static_cast<T *>(p);
+  }
+
+
+  void deallocate(T *p, std::size_t n) noexcept {
+    auto size = n*sizeof(T);
+    ::operator delete(p, size, std::align_val_t { alignment_for(size) });
+  }
+
+
+  template <typename U>
+  bool operator==(const aligned_allocator<U> &other) const noexcept {
+    return alignment == other.alignment && huge_pages == other.huge_pages;
+  }
+
+private:
+
+  /// Test if an allocation of \p size bytes uses huge pages
+  bool use_huge_pages(std::size_t size) const {
+    return huge_pages && size >= huge_page_size;
+  }
+
+
+  /// Compute the alignment used for an allocation of \p size bytes
+  std::size_t alignment_for(std::size_t size) const {
+    auto a = std::max(alignment, alignof(T));
+    return use_huge_pages(size) ? std::max(a, huge_page_size) : a;
+  }
+};
+
+/// @} End the helpers Doxygen group
+
+}
+
+/*
+    # Some Emacs stuff:
+    ### Local Variables:
+    ### ispell-local-dictionary: "american"
+    ### eval: (flyspell-prog-mode)
+    ### End:
+*/
+
+#endif // TRISYCL_SYCL_DETAIL_ALIGNED_ALLOCATOR_HPP
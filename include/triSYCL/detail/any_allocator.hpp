@@ -0,0 +1,104 @@
+#ifndef TRISYCL_SYCL_DETAIL_ANY_ALLOCATOR_HPP
+#define TRISYCL_SYCL_DETAIL_ANY_ALLOCATOR_HPP
+
+/** \file A type-erased allocator, to use the allocator of a buffer
+    without changing the type of its implementation
+
+    This file is distributed under the University of Illinois Open Source
+    License. See LICENSE.TXT for details.
+*/
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+namespace trisycl::detail {
+
+/** \addtogroup helpers Some helpers for the implementation
+    @{
+*/
+
+/** A copyable allocator of \c T forwarding to any other allocator
+
+    The default \c std::allocator is used without any indirection nor
+    heap allocation, which is the common case.
+*/
+template <typename T>
+class any_allocator {
+
+  /// The interface of the erased allocators
+  struct concept_t {
+    virtual T *allocate(std::size_t n) = 0;
+    virtual void deallocate(T *p, std::size_t n) noexcept = 0;
+    virtual ~concept_t() = default;
+  };
+
+
+  /// The erased allocator, rebound to \c T
+  template <typename Allocator>
+  struct model : concept_t {
+    using traits = typename std::allocator_traits<Allocator>
+      ::template rebind_traits<T>;
+
+    typename traits::allocator_type allocator;
+
+    model(const Allocator &a) : allocator { a } {}
+
+    T *allocate(std::size_t n) override {
+      return traits::allocate(allocator, n);
+    }
+
+    void deallocate(T *p, std::size_t n) noexcept override {
+      traits::deallocate(allocator, p, n);
+    }
+  };
+
+  /** The erased allocator shared by the copies, or nothing for \c
+      std::allocator */
+  std::shared_ptr<concept_t> erased;
+
+public:
+
+  using value_type = T;
+
+  /// Use \c std::allocator
+  any_allocator() = default;
+
+
+  /// Use a copy of allocator \p a, rebound to \c T
+  template <typename Allocator>
+    requires (!std::is_same_v<Allocator, any_allocator>)
+  any_allocator(const Allocator &a) {
+    using rebound = typename std::allocator_traits<Allocator>
+      ::template rebind_alloc<T>;
+    if constexpr (!std::is_same_v<rebound, std::allocator<T>>)
+      erased = std::make_shared<model<Allocator>>(a);
+  }
+
+
+  T *allocate(std::size_t n) {
+    return erased ? erased->allocate(n) : std::allocator<T> {}.allocate(n);
+  }
+
+
+  void deallocate(T *p, std::size_t n) noexcept {
+    if (erased)
+      erased->deallocate(p, n);
+    else
+      std::allocator<T> {}.deallocate(p, n);
+  }
+};
+
+/// @} End the helpers Doxygen group
+
+}
+
+/*
+    # Some Emacs stuff:
+    ### Local Variables:
+    ### ispell-local-dictionary: "american"
+    ### eval: (flyspell-prog-mode)
+    ### End:
+*/
+
+#endif // TRISYCL_SYCL_DETAIL_ANY_ALLOCATOR_HPP
@@ -0,0 +1,74 @@
+#ifndef TRISYCL_SYCL_DETAIL_ATOMIC_WAIT_HPP
+#define TRISYCL_SYCL_DETAIL_ATOMIC_WAIT_HPP
+
+/** \file Block on an atomic value without any lock, with a fast path
+    when nobody waits
+
+    This file is distributed under the University of Illinois Open Source
+    License. See LICENSE.TXT for details.
+*/
+
+#include <atomic>
+#include <cstddef>
+
+namespace trisycl::detail {
+
+/** \addtogroup execution Platforms, contexts, devices and queues
+    @{
+*/
+
+/** Block until an atomic value satisfies a predicate
+
+    The waiting threads are counted so that \c notify_waiters() can
+    avoid any system call when nobody is waiting.
+
+    \param[in] value is the atomic to wait on
+
+    \param[inout] waiters counts the threads waiting on \p value
+
+    \param[in] ready is the predicate on the value to wait for
+*/
+template <typename T, typename Predicate>
+void wait_until(const std::atomic<T> &value,
+                std::atomic<std::size_t> &waiters,
+                Predicate ready) {
+  auto v = value.load();
+  if (ready(v))
+    // Fast path without registering as a waiter
+    return;
+  ++waiters;
+  /* Since the waiter is registered before checking the value again in
+     wait(), a modification followed by notify_waiters() cannot be
+     missed */
+  while (!ready(v)) {
+    value.wait(v);
+    v = value.load();
+  }
+  --waiters;
+}
+
+
+/** Wake up the threads waiting on an atomic value, if any
+
+    To be called after modifying the value.
+*/
+template <typename T>
+void notify_waiters(std::atomic<T> &value,
+                    const std::atomic<std::size_t> &waiters) {
+  if (waiters != 0)
+    value.notify_all();
+}
+
+/// @} End the execution Doxygen group
+
+}
+
+/*
+    # Some Emacs stuff:
+    ### Local Variables:
+    ### ispell-local-dictionary: "american"
+    ### eval: (flyspell-prog-mode)
+    ### End:
+*/
+
+#endif // TRISYCL_SYCL_DETAIL_ATOMIC_WAIT_HPP
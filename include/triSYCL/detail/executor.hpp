@@ -0,0 +1,317 @@
+#ifndef TRISYCL_SYCL_DETAIL_EXECUTOR_HPP
+#define TRISYCL_SYCL_DETAIL_EXECUTOR_HPP
+
+/** \file The runtime-wide executor running the command groups
+
+    Instead of creating an OS thread per command group, the work is
+    run by a pool of worker threads created once.
+
+    This file is distributed under the University of Illinois Open Source
+    License. See LICENSE.TXT for details.
+*/
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "triSYCL/detail/debug.hpp"
+#include "triSYCL/detail/singleton.hpp"
+#include "triSYCL/detail/small_function.hpp"
+#include "triSYCL/detail/trace.hpp"
+
+namespace trisycl::detail {
+
+/** \addtogroup execution Platforms, contexts, devices and queues
+    @{
+*/
+
+/** The runtime-wide executor running the command groups
+
+    This is a pool of worker threads sized from the hardware topology,
+    consuming some work from a FIFO ready queue per priority level,
+    the highest priority ready work being executed first.
+
+    Since some kernels may block or spin waiting for each other, for
+    example through pipes, the pool cannot be strictly fixed or it
+    could dead-lock. So a watchdog adds a spare worker when there is
+    some ready work, no idle worker and no work has been started for
+    a while. A spare worker exits once it has been idle for a while,
+    so that a burst of blocking kernels does not leave the pool
+    oversubscribed.
+*/
+class executor : public detail::singleton<executor>,
+                 detail::debug<executor> {
+
+public:
+
+  /** The type-erased work to execute
+
+      A closure capturing a task \c std::shared_ptr is stored without
+      any heap allocation */
+  using work = detail::small_function<void(void)>;
+
+  /// The number of priority levels, 0 being the lowest one
+  static constexpr std::size_t priority_levels = 3;
+
+  /// The priority level used by default
+  static constexpr std::size_t normal_priority = 1;
+
+private:
+
+  /// Time without any progress before adding a spare worker
+  static constexpr auto starvation_delay = std::chrono::milliseconds { 10 };
+
+  /// Time without any work before a spare worker exits
+  static constexpr auto spare_idle_delay = std::chrono::seconds { 1 };
+
+  /// The work ready to be executed, in submission order per priority
+  std::array<std::deque<work>, priority_levels> ready;
+
+  /// To protect the executor state
+  std::mutex m;
+
+  /// To signal the workers when some work is ready or on termination
+  std::condition_variable work_available;
+
+  /// To wake up the watchdog when the workers might be starving
+  std::condition_variable maybe_starving;
+
+  /// The worker threads, including the spare ones
+  std::vector<std::thread> workers;
+
+  /// The spare workers which have exited, to be joined by the watchdog
+  std::vector<std::thread::id> exited;
+
+  /// The thread watching for starvation
+  std::thread watchdog;
+
+  /// Number of workers waiting for some work
+  std::size_t idle = 0;
+
+  /// Number of works started so far, to measure the progress
+  std::uint64_t started = 0;
+
+  /// Set on destruction to ask the threads to finish
+  bool stopping = false;
+
+  /** Set once the executor is being destroyed at the program exit,
+      after which \c instance() cannot be used anymore */
+  static inline std::atomic<bool> shut_down = false;
+
+public:
+
+  /// Create the pool with a worker per hardware thread
+  executor() {
+    /* Create the tracer first so that it is destroyed after the
+       workers are joined */
+    detail::tracer::get();
+    auto size = std::max(1U, std::thread::hardware_concurrency());
+    std::lock_guard<std::mutex> lg { m };
+    for (unsigned int i = 0; i != size; ++i)
+      add_worker(false);
+    watchdog = std::thread { [&] { watch(); } };
+    TRISYCL_DUMP_T("Executor started with " << size << " workers");
+  }
+
+
+  /** Submit some work to be executed by a worker
+
+      \param[in] w is the callable to execute, taking no argument
+
+      \param[in] priority is the priority level of the work, the
+      ready work of higher priority being started first
+  */
+  void submit(work w, std::size_t priority = normal_priority) {
+    {
+      std::lock_guard<std::mutex> lg { m };
+      ready[priority].push_back(std::move(w));
+      if (idle == 0)
+        // Nobody is available, so the watchdog might have some work
+        maybe_starving.notify_one();
+    }
+    work_available.notify_one();
+  }
+
+
+  /** Test if the executor has been shut down at the program exit
+
+      The objects destroyed after it, such as some buffers with a
+      static storage duration, have to do their work by themselves.
+  */
+  static bool is_shut_down() {
+    return shut_down;
+  }
+
+
+  /// Return the current number of workers
+  std::size_t size() {
+    std::lock_guard<std::mutex> lg { m };
+    return workers.size() - exited.size();
+  }
+
+
+  /** Test if there is some ready work of a priority strictly higher
+      than \p priority
+
+      This is used by some long work to yield to more urgent work by
+      resubmitting the rest of itself, so that a worker picks up the
+      more urgent work first.
+  */
+  bool has_higher_priority(std::size_t priority) {
+    std::lock_guard<std::mutex> lg { m };
+    auto level = highest_ready();
+    return level != priority_levels && level > priority;
+  }
+
+
+  /// Execute the remaining work and join all the threads
+  ~executor() {
+    shut_down = true;
+    {
+      std::lock_guard<std::mutex> lg { m };
+      stopping = true;
+    }
+    work_available.notify_all();
+    maybe_starving.notify_all();
+    // The watchdog is the only one adding workers, so join it first
+    watchdog.join();
+    for (auto &w : workers)
+      w.join();
+  }
+
+private:
+
+  /** Add a new worker, to be called with the executor lock taken
+
+      \param[in] spare is true for a worker exiting when idle
+  */
+  void add_worker(bool spare) {
+    workers.emplace_back([=, this] { run(spare); });
+  }
+
+
+  /** Join the spare workers which have exited, to be called with the
+      executor lock taken through \p ul */
+  void join_exited(std::unique_lock<std::mutex> &ul) {
+    if (exited.empty())
+      return;
+    std::vector<std::thread> to_join;
+    for (auto id : exited) {
+      auto w = std::ranges::find(workers, id, &std::thread::get_id);
+      to_join.push_back(std::move(*w));
+      workers.erase(w);
+    }
+    exited.clear();
+    // They only have to return, but do not block the workers meanwhile
+    ul.unlock();
+    for (auto &w : to_join)
+      w.join();
+    ul.lock();
+  }
+
+
+  /** Get the highest priority level with some ready work, to be
+      called with the executor lock taken
+
+      \return \c priority_levels if there is no ready work
+  */
+  std::size_t highest_ready() const {
+    for (auto level = priority_levels; level-- != 0;)
+      if (!ready[level].empty())
+        return level;
+    return priority_levels;
+  }
+
+
+  /// Test if there is some ready work, with the executor lock taken
+  bool has_ready() const {
+    return highest_ready() != priority_levels;
+  }
+
+
+  /** The loop of a worker executing the ready work
+
+      \param[in] spare is true for a worker exiting when idle
+  */
+  void run(bool spare) {
+    detail::tracer::get().set_thread_label("executor worker");
+    std::unique_lock<std::mutex> ul { m };
+    auto has_work = [&] { return stopping || has_ready(); };
+    for (;;) {
+      ++idle;
+      if (!spare)
+        work_available.wait(ul, has_work);
+      else if (!work_available.wait_for(ul, spare_idle_delay, has_work)) {
+        // Not needed anymore, so let the watchdog join this worker
+        --idle;
+        exited.push_back(std::this_thread::get_id());
+        maybe_starving.notify_one();
+        return;
+      }
+      --idle;
+      auto level = highest_ready();
+      if (level == priority_levels)
+        // Only when stopping, since the remaining work is drained first
+        return;
+      auto w = std::move(ready[level].front());
+      ready[level].pop_front();
+      ++started;
+      if (has_ready() && idle == 0)
+        /* Some work was submitted while this worker was still counted
+           as idle, so the watchdog has not been told about it */
+        maybe_starving.notify_one();
+      ul.unlock();
+      w();
+      // Destroy the work and what it captures outside of the lock
+      w = nullptr;
+      ul.lock();
+    }
+  }
+
+
+  /// The loop adding a spare worker when the existing ones are stuck
+  void watch() {
+    std::unique_lock<std::mutex> ul { m };
+    for (;;) {
+      maybe_starving.wait(ul, [&] {
+        return stopping || !exited.empty() || (has_ready() && idle == 0);
+      });
+      if (stopping)
+        return;
+      join_exited(ul);
+      if (!has_ready() || idle != 0)
+        continue;
+      auto started_before = started;
+      // Give some time to the busy workers to pick up the ready work
+      maybe_starving.wait_for(ul, starvation_delay, [&] { return stopping; });
+      if (!stopping && has_ready() && idle == 0
+          && started == started_before) {
+        TRISYCL_DUMP_T("Executor starving, adding a spare worker");
+        add_worker(true);
+      }
+    }
+  }
+
+};
+
+/// @} End the execution Doxygen group
+
+}
+
+/*
+    # Some Emacs stuff:
+    ### Local Variables:
+    ### ispell-local-dictionary: "american"
+    ### eval: (flyspell-prog-mode)
+    ### End:
+*/
+
+#endif // TRISYCL_SYCL_DETAIL_EXECUTOR_HPP
@@ -0,0 +1,179 @@
+#ifndef TRISYCL_SYCL_DETAIL_FILE_MAPPING_HPP
+#define TRISYCL_SYCL_DETAIL_FILE_MAPPING_HPP
+
+/** \file A part of a file mapped in memory
+
+    This file is distributed under the University of Illinois Open Source
+    License. See LICENSE.TXT for details.
+*/
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "triSYCL/exception.hpp"
+
+namespace trisycl::detail {
+
+/** \addtogroup helpers Some helpers for the implementation
+    @{
+*/
+
+/** Map a part of a file in memory, so that the pages are brought in
+    by the page cache on demand instead of being read and copied
+
+    A read-only mapping can only be read. A writable mapping is shared
+    with the file and synchronized with it on destruction.
+*/
+class file_mapping {
+
+  /// The start of the mapped pages
+  void *base = MAP_FAILED;
+
+  /// The size of the mapped pages
+  std::size_t mapped_size = 0;
+
+  /// The offset of the requested data in the mapped pages
+  std::size_t start = 0;
+
+  /// If the modifications are written back to the file
+  bool writable = false;
+
+public:
+
+  /** Map a part of an open file
+
+      \param[in] fd is the file descriptor, which can be closed once
+      the mapping is created
+
+      \param[in] offset is the position in bytes of the data in the
+      file, which does not need to be aligned on a page
+
+      \param[in] length is the number of bytes to map
+
+      \param[in] writable maps the file for writing instead of only
+      for reading
+
+      \throw invalid_parameter_error if the file is shorter than \p
+      offset + \p length bytes, since accessing the pages beyond the
+      end of the file would raise a \c SIGBUS
+  */
+  file_mapping(int fd, std::size_t offset, std::size_t length,
+               bool writable)
+    : writable { writable } {
+    struct ::stat st;
+    if (::fstat(fd, &st) != 0)
+      throw invalid_parameter_error { "Cannot get the size of the file" };
+    auto size = static_cast<std::size_t>(st.st_size);
+    // Written so that a large offset or length cannot wrap around
+    if (offset > size || length > size - offset)
+      throw invalid_parameter_error {
+        "The file is too short for the requested buffer" };
+    // The offset of a mapping has to be a multiple of the page size
+    auto page_size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    start = offset % page_size;
+    mapped_size = start + length;
+    if (length == 0)
+      // An empty mapping is not allowed but there is nothing to map
+      return;
+    base = ::mmap(nullptr, mapped_size,
+                  writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                  MAP_SHARED, fd, offset - start);
+    if (base == MAP_FAILED)
+      throw memory_allocation_error { "Cannot map the file in memory" };
+  }
+
+
+  /** Map a part of a file given by its path
+
+      \param[in] path is the name of the file
+
+      \param[in] offset is the position in bytes of the data in the file
+
+      \param[in] length is the number of bytes to map
+
+      \param[in] writable maps the file for writing instead of only
+      for reading
+  */
+  file_mapping(const std::filesystem::path &path,
+               std::size_t offset, std::size_t length,
+               bool writable)
+    : file_mapping { opened_file { path, writable }.fd,
+                     offset, length, writable } {}
+
+
+  file_mapping(file_mapping &&other) noexcept
+    : base { std::exchange(other.base, MAP_FAILED) }
+    , mapped_size { other.mapped_size }
+    , start { other.start }
+    , writable { other.writable } {}
+
+
+  file_mapping(const file_mapping &) = delete;
+  file_mapping &operator=(const file_mapping &) = delete;
+
+
+  /// Write back the modifications if any and unmap the file
+  ~file_mapping() {
+    if (base == MAP_FAILED)
+      return;
+    sync();
+    ::munmap(base, mapped_size);
+  }
+
+
+  /// Get the address of the mapped data
+  void *data() const {
+    if (base == MAP_FAILED)
+      return nullptr;
+    return static_cast<std::byte *>(base) + start;
+  }
+
+
+  /// Test if the modifications are written back to the file
+  bool is_writable() const { return writable; }
+
+
+  /// Write back synchronously the modifications to the file
+  void sync() {
+    if (writable && base != MAP_FAILED)
+      ::msync(base, mapped_size, MS_SYNC);
+  }
+
+private:
+
+  /// A file descriptor closed at the end of its scope
+  struct opened_file {
+    int fd;
+
+    opened_file(const std::filesystem::path &path, bool writable)
+      : fd { ::open(path.c_str(),
+                    (writable ? O_RDWR : O_RDONLY) | O_CLOEXEC) } {
+      if (fd < 0)
+        throw invalid_parameter_error { "Cannot open file "
+                                        + path.string() };
+    }
+
+    ~opened_file() { ::close(fd); }
+  };
+};
+
+/// @} End the helpers Doxygen group
+
+}
+
+/*
+    # Some Emacs stuff:
+    ### Local Variables:
+    ### ispell-local-dictionary: "american"
+    ### eval: (flyspell-prog-mode)
+    ### End:
+*/
+
+#endif // TRISYCL_SYCL_DETAIL_FILE_MAPPING_HPP
@@ -0,0 +1,153 @@
+#ifndef TRISYCL_SYCL_DETAIL_PARALLEL_COPY_HPP
+#define TRISYCL_SYCL_DETAIL_PARALLEL_COPY_HPP
+
+/** \file Bulk copies split across the workers of the runtime executor
+
+    This file is distributed under the University of Illinois Open Source
+    License. See LICENSE.TXT for details.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+
+#include "triSYCL/detail/atomic_wait.hpp"
+#include "triSYCL/detail/executor.hpp"
+
+namespace trisycl::detail {
+
+/** \addtogroup helpers Some helpers for the implementation
+    @{
+*/
+
+/// Below this size in bytes, a copy is done by the calling thread alone
+inline constexpr std::size_t parallel_copy_threshold = 4 << 20;
+
+/// The size in bytes of the blocks of a parallel copy
+inline constexpr std::size_t parallel_copy_block = 1 << 20;
+
+
+/** Call \p f(begin, end) on each block of \p block elements of [0, \p
+    n[ with the workers of the runtime executor
+
+    The calling thread processes some blocks too, so the work
+    completes even when all the workers are busy, for example when
+    called from a kernel or from a buffer destroyed by a worker.
+
+    Once the executor has been shut down at the program exit, the
+    calling thread processes all the blocks.
+*/
+template <typename F>
+void parallel_blocks(std::size_t n, std::size_t block, F f) {
+  auto blocks = (n + block - 1)/block;
+  if (blocks <= 1 || executor::is_shut_down()) {
+    f(0, n);
+    return;
+  }
+  // Shared with the workers, which might start after the end of the copy
+  struct state {
+    F f;
+    std::size_t n;
+    std::size_t block;
+    std::size_t blocks;
+    std::atomic<std::size_t> next = 0;
+    std::atomic<std::size_t> done = 0;
+    std::atomic<std::size_t> waiters = 0;
+
+    /// Process the blocks not taken yet by other threads
+    void run() {
+      for (std::size_t b; (b = next++) < blocks;) {
+        f(b*block, std::min(n, (b + 1)*block));
+        if (++done == blocks)
+          notify_waiters(done, waiters);
+      }
+    }
+  };
+  auto s = std::make_shared<state>(std::move(f), n, block, blocks);
+  auto e = detail::executor::instance();
+  auto helpers = std::min(blocks - 1, e->size());
+  for (std::size_t i = 0; i != helpers; ++i)
+    e->submit([s] { s->run(); });
+  s->run();
+  // Wait for the blocks taken by the workers
+  wait_until(s->done, s->waiters,
+             [&] (std::size_t d) { return d == blocks; });
+}
+
+
+/** Copy \p n elements from \p first to \p result, in parallel for a
+    large copy between random-access iterators
+
+    A copy between contiguous arrays of trivially copyable elements
+    uses \c std::memcpy per block, which uses non-temporal stores for
+    large sizes on common platforms, to avoid evicting the caches.
+*/
+template <typename InputIterator, typename OutputIterator>
+void parallel_copy_n(InputIterator first, std::size_t n,
+                     OutputIterator result) {
+  using value_type = std::iter_value_t<InputIterator>;
+  if constexpr (std::random_access_iterator<InputIterator>
+                && std::random_access_iterator<OutputIterator>) {
+    using output_type = std::iter_value_t<OutputIterator>;
+    if constexpr (std::is_nothrow_assignable_v<output_type&,
+                                               const value_type&>) {
+      if (n*sizeof(value_type) >= parallel_copy_threshold) {
+        auto block = std::max<std::size_t>(1,
+                                           parallel_copy_block
+                                           /sizeof(value_type));
+        parallel_blocks(n, block, [=] (std::size_t b, std::size_t e) {
+            if constexpr (std::contiguous_iterator<InputIterator>
+                          && std::contiguous_iterator<OutputIterator>
+                          && std::is_same_v<value_type, output_type>
+                          && std::is_trivially_copyable_v<value_type>)
+              std::memcpy(std::to_address(result + b),
+                          std::to_address(first + b),
+                          (e - b)*sizeof(value_type));
+            else
+              std::copy_n(first + b, e - b, result + b);
+          });
+        return;
+      }
+    }
+  }
+  std::copy_n(first, n, result);
+}
+
+
+/** Copy-construct \p n elements from \p first into the uninitialized
+    memory at \p result, in parallel for a large copy */
+template <typename T>
+void parallel_uninitialized_copy_n(const T *first, std::size_t n,
+                                   T *result) {
+  if constexpr (std::is_nothrow_copy_constructible_v<T>) {
+    if (n*sizeof(T) >= parallel_copy_threshold) {
+      auto block = std::max<std::size_t>(1, parallel_copy_block/sizeof(T));
+      parallel_blocks(n, block, [=] (std::size_t b, std::size_t e) {
+          if constexpr (std::is_trivially_copyable_v<T>)
+            std::memcpy(result + b, first + b, (e - b)*sizeof(T));
+          else
+            std::uninitialized_copy_n(first + b, e - b, result + b);
+        });
+      return;
+    }
+  }
+  std::uninitialized_copy_n(first, n, result);
+}
+
+/// @} End the helpers Doxygen group
+
+}
+
+/*
+    # Some Emacs stuff:
+    ### Local Variables:
+    ### ispell-local-dictionary: "american"
+    ### eval: (flyspell-prog-mode)
+    ### End:
+*/
+
+#endif // TRISYCL_SYCL_DETAIL_PARALLEL_COPY_HPP
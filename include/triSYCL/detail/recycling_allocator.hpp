@@ -0,0 +1,153 @@
+#ifndef TRISYCL_SYCL_DETAIL_RECYCLING_ALLOCATOR_HPP
+#define TRISYCL_SYCL_DETAIL_RECYCLING_ALLOCATOR_HPP
+
+/** \file An allocator recycling the memory of the objects of the same
+    size, such as the tasks of a queue
+
+    This file is distributed under the University of Illinois Open Source
+    License. See LICENSE.TXT for details.
+*/
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "triSYCL/detail/debug.hpp"
+
+namespace trisycl::detail {
+
+/** \addtogroup helpers Some helpers for the implementation
+    @{
+*/
+
+/** A pool keeping the freed memory blocks of a given size for reuse
+
+    The block size is set by the first allocation. Since a pool is
+    used for objects of a single type, the other sizes are just
+    forwarded to the global allocator.
+
+    The blocks may be freed by another thread than the allocating
+    one, for example when a task completes on a worker thread.
+*/
+class recycling_pool : public detail::debug<recycling_pool> {
+
+  /// Maximum number of free blocks kept for later reuse
+  static constexpr std::size_t max_free_blocks = 256;
+
+  /// The blocks available for reuse
+  std::vector<void *> free_blocks;
+
+  /// The size of the recycled blocks, 0 before the first allocation
+  std::size_t block_size = 0;
+
+  /// To protect the pool state
+  std::mutex m;
+
+public:
+
+  recycling_pool() {
+    // Never reallocate the free list while recycling
+    free_blocks.reserve(max_free_blocks);
+  }
+
+
+  /// Allocate a block of \p size bytes with the default new alignment
+  void *allocate(std::size_t size) {
+    {
+      std::lock_guard<std::mutex> lg { m };
+      if (block_size == 0)
+        block_size = size;
+      if (size == block_size && !free_blocks.empty()) {
+        auto p = free_blocks.back();
+        free_blocks.pop_back();
+        return p;
+      }
+    }
+    return ::operator new(size);
+  }
+
+
+  /// Free a block of \p size bytes, keeping it for reuse if possible
+  void deallocate(void *p, std::size_t size) noexcept {
+    {
+      std::lock_guard<std::mutex> lg { m };
+      if (size == block_size && free_blocks.size() < max_free_blocks) {
+        free_blocks.push_back(p);
+        return;
+      }
+    }
+    ::operator delete(p, size);
+  }
+
+
+  ~recycling_pool() {
+    for (auto p : free_blocks)
+      ::operator delete(p, block_size);
+  }
+
+};
+
+
+/** A standard allocator using a \c recycling_pool
+
+    This is typically used with \c std::allocate_shared so that the
+    object and its control block are recycled together. Since each
+    copy of the allocator owns the pool, the pool lives as long as
+    any object allocated from it.
+*/
+template <typename T>
+struct recycling_allocator {
+  using value_type = T;
+
+  /// The pool providing the memory
+  std::shared_ptr<recycling_pool> pool;
+
+
+  recycling_allocator(std::shared_ptr<recycling_pool> p) noexcept
+    : pool { std::move(p) } {}
+
+
+  /// Rebind from an allocator of another type
+  template <typename U>
+  recycling_allocator(const recycling_allocator<U> &other) noexcept
+    : pool { other.pool } {}
+
+
+  T *allocate(std::size_t n) {
+    if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+      // Not handled by the pool
+      return std::allocator<T> {}.allocate(n);
+    else
+      return static_cast<T *>(pool->allocate(n*sizeof(T)));
+  }
+
+
+  void deallocate(T *p, std::size_t n) noexcept {
+    if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+      std::allocator<T> {}.deallocate(p, n);
+    else
+      pool->deallocate(p, n*sizeof(T));
+  }
+
+
+  template <typename U>
+  bool operator==(const recycling_allocator<U> &other) const noexcept {
+    return pool == other.pool;
+  }
+};
+
+/// @} End the helpers Doxygen group
+
+}
+
+/*
+    # Some Emacs stuff:
+    ### Local Variables:
+    ### ispell-local-dictionary: "american"
+    ### eval: (flyspell-prog-mode)
+    ### End:
+*/
+
+#endif // TRISYCL_SYCL_DETAIL_RECYCLING_ALLOCATOR_HPP
@@ -0,0 +1,186 @@
+#ifndef TRISYCL_SYCL_DETAIL_SIZE_CLASS_POOL_HPP
+#define TRISYCL_SYCL_DETAIL_SIZE_CLASS_POOL_HPP
+
+/** \file A pool of memory blocks of any size, recycled per size class
+
+    This file is distributed under the University of Illinois Open Source
+    License. See LICENSE.TXT for details.
+*/
+
+#include <bit>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "triSYCL/detail/debug.hpp"
+
+namespace trisycl::detail {
+
+/** \addtogroup helpers Some helpers for the implementation
+    @{
+*/
+
+/** A pool keeping the freed memory blocks for reuse by later
+    allocations of the same size class
+
+    Unlike \c recycling_pool, it handles blocks of any size. The sizes
+    are rounded up to a size class, with 4 classes per power of 2 to
+    waste at most 25% of the memory, so that blocks of slightly
+    different sizes can be recycled.
+
+    The blocks are aligned on a cache line.
+*/
+class size_class_pool : public detail::debug<size_class_pool> {
+
+public:
+
+  /// The alignment of all the blocks
+  static constexpr std::size_t alignment = 64;
+
+private:
+
+  /// The maximum number of bytes kept in the free blocks
+  static constexpr std::size_t max_free_bytes = std::size_t { 1 } << 30;
+
+  /// The blocks available for reuse, per size class
+  std::map<std::size_t, std::vector<void *>> free_blocks;
+
+  /// The number of bytes in the free blocks
+  std::size_t free_bytes = 0;
+
+  /// To protect the pool state
+  std::mutex m;
+
+public:
+
+  /** Get the pool shared by the runtime
+
+      Each user keeps it alive, so it can be used during the static
+      destruction.
+  */
+  static std::shared_ptr<size_class_pool> instance() {
+    static auto pool = std::make_shared<size_class_pool>();
+    return pool;
+  }
+
+
+  /// Round up a size in bytes to its size class
+  static std::size_t size_class(std::size_t size) {
+    if (size <= alignment)
+      return alignment;
+    // The step between the 4 classes of this power of 2
+    auto step = std::bit_ceil(size) >> 3;
+    return (size + step - 1) & ~(step - 1);
+  }
+
+
+  /// Allocate a block of at least \p size bytes
+  void *allocate(std::size_t size) {
+    auto rounded = size_class(size);
+    {
+      std::lock_guard<std::mutex> lg { m };
+      if (auto f = free_blocks.find(rounded);
+          f != free_blocks.end() && !f->second.empty()) {
+        auto p = f->second.back();
+        f->second.pop_back();
+        free_bytes -= rounded;
+        return p;
+      }
+    }
+    return ::operator new(rounded, std::align_val_t { alignment });
+  }
+
+
+  /// Free a block of \p size bytes, keeping it for reuse if possible
+  void deallocate(void *p, std::size_t size) noexcept {
+    auto rounded = size_class(size);
+    try {
+      std::lock_guard<std::mutex> lg { m };
+      if (free_bytes + rounded <= max_free_bytes) {
+        free_blocks[rounded].push_back(p);
+        free_bytes += rounded;
+        return;
+      }
+    } catch (...) {
+      // Cannot keep track of the block, so just free it
+    }
+    ::operator delete(p, rounded, std::align_val_t { alignment });
+  }
+
+
+  /// Free all the blocks kept for reuse
+  void release() {
+    std::lock_guard<std::mutex> lg { m };
+    for (auto &[rounded, blocks] : free_blocks)
+      for (auto p : blocks)
+        ::operator delete(p, rounded, std::align_val_t { alignment });
+    free_blocks.clear();
+    free_bytes = 0;
+  }
+
+
+  ~size_class_pool() {
+    release();
+  }
+
+};
+
+
+/** A standard allocator using the \c size_class_pool shared by the
+    runtime
+
+    Each copy of the allocator owns the pool, so the pool lives as long
+    as any memory allocated from it.
+*/
+template <typename T>
+struct size_class_allocator {
+  using value_type = T;
+
+  static_assert(alignof(T) <= size_class_pool::alignment,
+                "the alignment of the type is too large for the pool");
+
+  /// The pool providing the memory
+  std::shared_ptr<size_class_pool> pool = size_class_pool::instance();
+
+
+  size_class_allocator() = default;
+
+
+  /// Rebind from an allocator of another type
+  template <typename U>
+  size_class_allocator(const size_class_allocator<U> &other) noexcept
+    : pool { other.pool } {}
+
+
+  T *allocate(std::size_t n) {
+    return static_cast<T *>(pool->allocate(n*sizeof(T)));
+  }
+
+
+  void deallocate(T *p, std::size_t n) noexcept {
+    pool->deallocate(p, n*sizeof(T));
+  }
+
+
+  template <typename U>
+  bool operator==(const size_class_allocator<U> &other) const noexcept {
+    return pool == other.pool;
+  }
+};
+
+/// @} End the helpers Doxygen group
+
+}
+
+/*
+    # Some Emacs stuff:
+    ### Local Variables:
+    ### ispell-local-dictionary: "american"
+    ### eval: (flyspell-prog-mode)
+    ### End:
+*/
+
+#endif // TRISYCL_SYCL_DETAIL_SIZE_CLASS_POOL_HPP
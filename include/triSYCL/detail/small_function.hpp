@@ -0,0 +1,189 @@
+#ifndef TRISYCL_SYCL_DETAIL_SMALL_FUNCTION_HPP
+#define TRISYCL_SYCL_DETAIL_SMALL_FUNCTION_HPP
+
+/** \file A move-only type-erased callable storing small closures
+    inline
+
+    This file is distributed under the University of Illinois Open Source
+    License. See LICENSE.TXT for details.
+*/
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace trisycl::detail {
+
+/** \addtogroup helpers Some helpers for the implementation
+    @{
+*/
+
+template <typename Signature, std::size_t InlineSize = 6*sizeof(void *)>
+class small_function;
+
+/** A move-only replacement of \c std::function avoiding the heap
+    allocation for the closures up to \p InlineSize bytes
+
+    Unlike \c std::function which only keeps inline some trivially
+    copyable callables of 2 pointers with libstdc++, a closure
+    capturing some \c std::shared_ptr such as the task or accessor
+    ones fits here. Larger closures are still allocated on the heap.
+
+    Since it is move-only, it can store some move-only callables.
+
+    \todo Add an allocator for the large closures
+*/
+template <typename R, typename... Args, std::size_t InlineSize>
+class small_function<R(Args...), InlineSize> {
+
+  /// The operations on the stored callable
+  struct operations {
+    R (*call)(void *storage, Args&&... args);
+    /// Move-construct the callable into \c to and destroy \c from
+    void (*relocate)(void *from, void *to) noexcept;
+    void (*destroy)(void *storage) noexcept;
+  };
+
+  /// Test if a callable type is stored inline
+  template <typename F>
+  static constexpr bool is_inline = sizeof(F) <= InlineSize
+    && alignof(F) <= alignof(std::max_align_t)
+    && std::is_nothrow_move_constructible_v<F>;
+
+  /// The operations for a callable stored inline
+  template <typename F>
+  static constexpr operations inline_operations {
+    [] (void *s, Args&&... args) -> R {
+      return std::invoke(*static_cast<F *>(s), std::forward<Args>(args)...);
+    },
+    [] (void *from, void *to) noexcept {
+      ::new (to) F { std::move(*static_cast<F *>(from)) };
+      static_cast<F *>(from)->~F();
+    },
+    [] (void *s) noexcept { static_cast<F *>(s)->~F(); }
+  };
+
+  /// The operations for a callable allocated on the heap
+  template <typename F>
+  static constexpr operations heap_operations {
+    [] (void *s, Args&&... args) -> R {
+      return std::invoke(**static_cast<F **>(s), std::forward<Args>(args)...);
+    },
+    [] (void *from, void *to) noexcept {
+      ::new (to) F * { *static_cast<F **>(from) };
+    },
+    [] (void *s) noexcept { delete *static_cast<F **>(s); }
+  };
+
+  /// The callable itself or a pointer to it if it does not fit
+  alignas(std::max_align_t) std::byte storage[InlineSize];
+
+  /// The operations of the current callable, or nullptr if empty
+  const operations *ops = nullptr;
+
+  static_assert(InlineSize >= sizeof(void *),
+                "There should be room at least for a pointer");
+
+public:
+
+  /// Create an empty function
+  small_function() noexcept = default;
+
+
+  small_function(std::nullptr_t) noexcept {}
+
+
+  /// Store a callable
+  template <typename F>
+    requires (!std::is_same_v<std::remove_cvref_t<F>, small_function>
+              && std::is_invocable_r_v<R, std::decay_t<F> &, Args...>)
+  small_function(F &&f) {
+    using callable = std::decay_t<F>;
+    if constexpr (is_inline<callable>) {
+      ::new (static_cast<void *>(storage)) callable { std::forward<F>(f) };
+      ops = &inline_operations<callable>;
+    }
+    else {
+      ::new (static_cast<void *>(storage))
+        callable * { new callable { std::forward<F>(f) } };
+      ops = &heap_operations<callable>;
+    }
+  }
+
+
+  small_function(small_function &&other) noexcept : ops { other.ops } {
+    if (ops) {
+      ops->relocate(other.storage, storage);
+      other.ops = nullptr;
+    }
+  }
+
+
+  small_function &operator=(small_function &&other) noexcept {
+    if (this != &other) {
+      reset();
+      if (other.ops) {
+        other.ops->relocate(other.storage, storage);
+        ops = std::exchange(other.ops, nullptr);
+      }
+    }
+    return *this;
+  }
+
+
+  small_function &operator=(std::nullptr_t) noexcept {
+    reset();
+    return *this;
+  }
+
+
+  ~small_function() {
+    reset();
+  }
+
+
+  /// Test if there is a callable
+  explicit operator bool() const noexcept {
+    return ops != nullptr;
+  }
+
+
+  /** Call the callable
+
+      Like \c std::function, this is const even if the callable
+      itself is mutable.
+  */
+  R operator()(Args... args) const {
+    if (!ops)
+      throw std::bad_function_call {};
+    return ops->call(const_cast<std::byte *>(storage),
+                     std::forward<Args>(args)...);
+  }
+
+private:
+
+  /// Destroy the callable if any
+  void reset() noexcept {
+    if (ops) {
+      ops->destroy(storage);
+      ops = nullptr;
+    }
+  }
+
+};
+
+/// @} End the helpers Doxygen group
+
+}
+
+/*
+    # Some Emacs stuff:
+    ### Local Variables:
+    ### ispell-local-dictionary: "american"
+    ### eval: (flyspell-prog-mode)
+    ### End:
+*/
+
+#endif // TRISYCL_SYCL_DETAIL_SMALL_FUNCTION_HPP
@@ -0,0 +1,211 @@
+#ifndef TRISYCL_SYCL_DETAIL_SMALL_VECTOR_HPP
+#define TRISYCL_SYCL_DETAIL_SMALL_VECTOR_HPP
+
+/** \file A vector storing its first elements inline
+
+    This file is distributed under the University of Illinois Open Source
+    License. See LICENSE.TXT for details.
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace trisycl::detail {
+
+/** \addtogroup helpers Some helpers for the implementation
+    @{
+*/
+
+/** A minimal vector with room for \p N elements inside the object
+
+    This avoids any heap allocation while there are no more than \p N
+    elements, which is the common case for the per-task lists like
+    the buffers used by a command group.
+
+    Only the part of the \c std::vector interface used by the runtime
+    is implemented.
+*/
+template <typename T, std::size_t N>
+class small_vector {
+
+  /// The elements, pointing to \c inline_storage or to the heap
+  T *elements;
+
+  /// The number of elements
+  std::size_t count = 0;
+
+  /// The room for elements available in \c elements
+  std::size_t room = N;
+
+  /// The room for the first elements
+  alignas(T) std::byte inline_storage[N*sizeof(T)];
+
+  static_assert(N > 0, "Use a std::vector without inline storage instead");
+
+public:
+
+  using value_type = T;
+  using size_type = std::size_t;
+  using iterator = T *;
+  using const_iterator = const T *;
+
+
+  small_vector() noexcept
+    : elements { reinterpret_cast<T *>(inline_storage) } {}
+
+
+  small_vector(const small_vector &other) : small_vector {} {
+    reserve(other.count);
+    std::uninitialized_copy(other.begin(), other.end(), elements);
+    count = other.count;
+  }
+
+
+  small_vector(small_vector &&other) noexcept : small_vector {} {
+    steal(other);
+  }
+
+
+  small_vector &operator=(const small_vector &other) {
+    if (this != &other) {
+      clear();
+      reserve(other.count);
+      std::uninitialized_copy(other.begin(), other.end(), elements);
+      count = other.count;
+    }
+    return *this;
+  }
+
+
+  small_vector &operator=(small_vector &&other) noexcept {
+    if (this != &other) {
+      clear();
+      release_heap();
+      steal(other);
+    }
+    return *this;
+  }
+
+
+  ~small_vector() {
+    clear();
+    release_heap();
+  }
+
+
+  iterator begin() noexcept { return elements; }
+  iterator end() noexcept { return elements + count; }
+  const_iterator begin() const noexcept { return elements; }
+  const_iterator end() const noexcept { return elements + count; }
+
+  T *data() noexcept { return elements; }
+  const T *data() const noexcept { return elements; }
+
+  std::size_t size() const noexcept { return count; }
+  std::size_t capacity() const noexcept { return room; }
+  bool empty() const noexcept { return count == 0; }
+
+  T &operator[](std::size_t i) noexcept { return elements[i]; }
+  const T &operator[](std::size_t i) const noexcept { return elements[i]; }
+
+  T &back() noexcept { return elements[count - 1]; }
+  const T &back() const noexcept { return elements[count - 1]; }
+
+
+  template <typename... Args>
+  T &emplace_back(Args &&...args) {
+    if (count == room) {
+      // Construct first since the arguments may refer to an element
+      T value { std::forward<Args>(args)... };
+      reserve(2*room);
+      return *::new (elements + count++) T { std::move(value) };
+    }
+    return *::new (elements + count++) T { std::forward<Args>(args)... };
+  }
+
+
+  void push_back(const T &value) { emplace_back(value); }
+
+
+  void push_back(T &&value) { emplace_back(std::move(value)); }
+
+
+  /// Destroy the elements but keep the storage for later reuse
+  void clear() noexcept {
+    std::destroy(begin(), end());
+    count = 0;
+  }
+
+
+  /// Make room for at least \p n elements
+  void reserve(std::size_t n) {
+    if (n <= room)
+      return;
+    auto bigger = static_cast<T *>(::operator new(n*sizeof(T),
+                                                  std::align_val_t {
+                                                    alignof(T) }));
+    std::uninitialized_move(begin(), end(), bigger);
+    std::destroy(begin(), end());
+    release_heap();
+    elements = bigger;
+    room = n;
+  }
+
+
+  void swap(small_vector &other) noexcept {
+    auto tmp = std::move(other);
+    other = std::move(*this);
+    *this = std::move(tmp);
+  }
+
+private:
+
+  /// Test if the elements are in the inline storage
+  bool is_inline() const noexcept {
+    return elements == reinterpret_cast<const T *>(inline_storage);
+  }
+
+
+  /// Free the heap storage, if any, without destroying any element
+  void release_heap() noexcept {
+    if (!is_inline()) {
+      ::operator delete(elements, std::align_val_t { alignof(T) });
+      elements = reinterpret_cast<T *>(inline_storage);
+      room = N;
+    }
+  }
+
+
+  /// Take the elements of another vector when this one is empty and inline
+  void steal(small_vector &other) noexcept {
+    if (other.is_inline()) {
+      std::uninitialized_move(other.begin(), other.end(), elements);
+      count = other.count;
+      other.clear();
+    }
+    else {
+      elements = std::exchange(other.elements,
+                               reinterpret_cast<T *>(other.inline_storage));
+      count = std::exchange(other.count, 0);
+      room = std::exchange(other.room, N);
+    }
+  }
+
+};
+
+/// @} End the helpers Doxygen group
+
+}
+
+/*
+    # Some Emacs stuff:
+    ### Local Variables:
+    ### ispell-local-dictionary: "american"
+    ### eval: (flyspell-prog-mode)
+    ### End:
+*/
+
+#endif // TRISYCL_SYCL_DETAIL_SMALL_VECTOR_HPP
@@ -0,0 +1,377 @@
+#ifndef TRISYCL_SYCL_DETAIL_TRACE_HPP
+#define TRISYCL_SYCL_DETAIL_TRACE_HPP
+
+/** \file Record the life of the tasks to export a Chrome trace
+
+    Unlike TRISYCL_DUMP_T, this is available in any build and enabled
+    at run-time, either by setting the TRISYCL_TRACE environment
+    variable to the name of the JSON file to write at exit, or on
+    demand.
+
+    This file is distributed under the University of Illinois Open Source
+    License. See LICENSE.TXT for details.
+*/
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/core/demangle.hpp>
+
+namespace trisycl::detail {
+
+/** \addtogroup execution Platforms, contexts, devices and queues
+    @{
+*/
+
+/// What happened to a task
+enum class trace_kind : std::uint8_t {
+  submit,     ///< The command group has been submitted
+  dependency, ///< The task depends on the producer task in \c other
+  access,     ///< The task uses the buffer in \c other
+  ready,      ///< All the producers have completed
+  start,      ///< The kernel starts
+  end         ///< The kernel ends
+};
+
+
+/// A trace record, kept small and trivially copyable
+struct trace_record {
+  /// Timestamp in nanoseconds
+  std::uint64_t time;
+  /// The serial number of the task
+  std::uint64_t task;
+  /// The producer task or the buffer, depending on the kind
+  std::uint64_t other;
+  /// The mangled kernel name or the access mode, with static storage
+  const char *name;
+  trace_kind kind;
+};
+
+
+/** The records of a single thread
+
+    It is only written by its thread, without any lock, and can be
+    read concurrently by the thread exporting the trace.
+*/
+class trace_buffer {
+
+  /// Number of records in a chunk
+  static constexpr std::size_t chunk_size = 4096;
+
+  struct chunk {
+    std::array<trace_record, chunk_size> records;
+    /// Number of records published in this chunk
+    std::atomic<std::size_t> count = 0;
+    std::unique_ptr<chunk> next;
+  };
+
+  /// The first chunk, the other ones being chained from it
+  std::unique_ptr<chunk> first = std::make_unique<chunk>();
+
+  /// The chunk currently written
+  chunk *last = first.get();
+
+  /// The next chunk, published once allocated
+  std::atomic<chunk *> published_last = first.get();
+
+public:
+
+  /// The label of the thread in the trace
+  std::atomic<const char *> label = nullptr;
+
+
+  /// Append a record, only from the owning thread
+  void append(const trace_record &r) {
+    auto n = last->count.load(std::memory_order_relaxed);
+    if (n == chunk_size) {
+      last->next = std::make_unique<chunk>();
+      last = last->next.get();
+      published_last.store(last, std::memory_order_release);
+      n = 0;
+    }
+    last->records[n] = r;
+    // Publish the record to the exporting thread
+    last->count.store(n + 1, std::memory_order_release);
+  }
+
+
+  /// Call \p f on each published record
+  template <typename F>
+  void for_each(F f) const {
+    auto end = published_last.load(std::memory_order_acquire);
+    for (auto c = first.get();; c = c->next.get()) {
+      auto n = c->count.load(std::memory_order_acquire);
+      for (std::size_t i = 0; i != n; ++i)
+        f(c->records[i]);
+      if (c == end)
+        return;
+    }
+  }
+};
+
+
+/** The runtime-wide tracer
+
+    This does not use detail::singleton to avoid a \c std::shared_ptr
+    copy on each record.
+*/
+class tracer {
+
+  /// The buffers of all the threads which have recorded something
+  std::vector<std::unique_ptr<trace_buffer>> buffers;
+
+  /// To protect the list of buffers
+  std::mutex m;
+
+  /// Is the tracing running
+  std::atomic<bool> active = false;
+
+  /// The serial number of the next traced task
+  std::atomic<std::uint64_t> next_task = 1;
+
+  /// The file to write at exit, if any
+  std::string exit_file;
+
+  /// The buffer of the current thread
+  static inline thread_local trace_buffer *local = nullptr;
+
+  /// The label of the current thread, used when its buffer is created
+  static inline thread_local const char *local_label = "host thread";
+
+  tracer() {
+    if (auto file = std::getenv("TRISYCL_TRACE")) {
+      exit_file = file;
+      active = true;
+    }
+  }
+
+public:
+
+  /// Get the tracer
+  static tracer &get() {
+    static tracer t;
+    return t;
+  }
+
+
+  /// Write the trace file asked by TRISYCL_TRACE, if any
+  ~tracer() {
+    if (!exit_file.empty())
+      write_chrome_trace(exit_file);
+  }
+
+
+  /// Start or stop the recording
+  void set_active(bool a) {
+    active = a;
+  }
+
+
+  /// Test if the recording is running, cheap enough for the hot paths
+  bool is_active() const {
+    return active.load(std::memory_order_relaxed);
+  }
+
+
+  /// Get a serial number for a new task, or 0 when not tracing
+  std::uint64_t new_task() {
+    return is_active() ? next_task.fetch_add(1, std::memory_order_relaxed)
+                       : 0;
+  }
+
+
+  /// Get a timestamp in nanoseconds
+  static std::uint64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+
+  /// Record something about a task, if it is traced
+  void record(trace_kind kind,
+              std::uint64_t task,
+              std::uint64_t other = 0,
+              const char *name = nullptr) {
+    if (task == 0 || !is_active())
+      return;
+    thread_buffer().append({ now(), task, other, name, kind });
+  }
+
+
+  /// Set the label of the current thread in the trace
+  void set_thread_label(const char *label) {
+    local_label = label;
+    if (local)
+      local->label = label;
+  }
+
+
+  /** Write the trace recorded so far in the Chrome trace event JSON
+      format, which can also be loaded by Perfetto
+
+      Each kernel execution is a slice on the track of its thread,
+      the dependencies between tasks being shown as flows.
+  */
+  void write_chrome_trace(std::ostream &o) {
+    struct task_info {
+      const char *name = nullptr;
+      std::uint64_t submit = 0, ready = 0, start = 0, end = 0;
+      std::size_t submit_thread = 0, start_thread = 0;
+      std::vector<std::uint64_t> producers;
+      std::vector<std::pair<std::uint64_t, const char *>> accesses;
+    };
+    std::unordered_map<std::uint64_t, task_info> tasks;
+    std::vector<const char *> labels;
+    {
+      std::lock_guard<std::mutex> lg { m };
+      for (std::size_t thread = 0; thread != buffers.size(); ++thread) {
+        labels.push_back(buffers[thread]->label);
+        buffers[thread]->for_each([&] (const trace_record &r) {
+          auto &t = tasks[r.task];
+          switch (r.kind) {
+          case trace_kind::submit:
+            t.name = r.name;
+            t.submit = r.time;
+            t.submit_thread = thread;
+            break;
+          case trace_kind::dependency:
+            t.producers.push_back(r.other);
+            break;
+          case trace_kind::access:
+            t.accesses.emplace_back(r.other, r.name);
+            break;
+          case trace_kind::ready:
+            t.ready = r.time;
+            break;
+          case trace_kind::start:
+            t.start = r.time;
+            t.start_thread = thread;
+            break;
+          case trace_kind::end:
+            t.end = r.time;
+            break;
+          }
+        });
+      }
+    }
+    // The microsecond timestamps expected by the format
+    auto us = [] (std::uint64_t ns) { return ns/1000.0; };
+    auto quoted = [] (const std::string &s) {
+      std::string q = "\"";
+      for (auto c : s) {
+        if (c == '"' || c == '\\')
+          q += '\\';
+        q += c;
+      }
+      return q + '"';
+    };
+    // Keep a sub-microsecond precision without any exponent
+    o << std::fixed << std::setprecision(3);
+    o << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    bool first = true;
+    auto separator = [&] {
+      if (!first)
+        o << ",\n";
+      first = false;
+    };
+    for (std::size_t thread = 0; thread != labels.size(); ++thread) {
+      separator();
+      o << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread
+        << ",\"args\":{\"name\":"
+        << quoted(std::string { labels[thread] } + " " + std::to_string(thread))
+        << "}}";
+    }
+    std::uint64_t flow = 0;
+    for (auto &[id, t] : tasks) {
+      if (t.start == 0 || t.end == 0)
+        // Not executed, or still running
+        continue;
+      auto name = t.name ? boost::core::demangle(t.name) : "command group";
+      separator();
+      o << "{\"name\":" << quoted(name) << ",\"cat\":\"kernel\",\"ph\":\"X\""
+        << ",\"pid\":1,\"tid\":" << t.start_thread
+        << ",\"ts\":" << us(t.start) << ",\"dur\":" << us(t.end - t.start)
+        << ",\"args\":{\"task\":" << id;
+      if (t.submit != 0)
+        o << ",\"submitted_us_before\":" << us(t.start - t.submit);
+      if (t.ready != 0)
+        o << ",\"ready_us_before\":" << us(t.start - t.ready);
+      o << ",\"producers\":[";
+      for (std::size_t i = 0; i != t.producers.size(); ++i)
+        o << (i ? "," : "") << t.producers[i];
+      o << "],\"buffers\":[";
+      for (std::size_t i = 0; i != t.accesses.size(); ++i)
+        o << (i ? "," : "")
+          << quoted(std::to_string(t.accesses[i].first) + " "
+                    + t.accesses[i].second);
+      o << "]}}";
+      if (t.submit != 0) {
+        separator();
+        o << "{\"name\":\"submit\",\"cat\":\"submit\",\"ph\":\"i\",\"s\":\"t\""
+          << ",\"pid\":1,\"tid\":" << t.submit_thread
+          << ",\"ts\":" << us(t.submit)
+          << ",\"args\":{\"task\":" << id << "}}";
+      }
+      for (auto p : t.producers) {
+        auto producer = tasks.find(p);
+        if (producer == tasks.end() || producer->second.end == 0)
+          continue;
+        ++flow;
+        separator();
+        o << "{\"name\":\"dependency\",\"cat\":\"dependency\",\"ph\":\"s\""
+          << ",\"id\":" << flow << ",\"pid\":1,\"tid\":"
+          << producer->second.start_thread
+          << ",\"ts\":" << us(producer->second.end) << "},\n"
+          << "{\"name\":\"dependency\",\"cat\":\"dependency\",\"ph\":\"f\""
+          << ",\"bp\":\"e\",\"id\":" << flow << ",\"pid\":1,\"tid\":"
+          << t.start_thread << ",\"ts\":" << us(t.start) << "}";
+      }
+    }
+    o << "\n]}\n";
+  }
+
+
+  /// Write the trace recorded so far into a Chrome trace JSON file
+  void write_chrome_trace(const std::string &file_name) {
+    std::ofstream f { file_name };
+    write_chrome_trace(f);
+  }
+
+private:
+
+  /// Get the buffer of the current thread, creating it if needed
+  trace_buffer &thread_buffer() {
+    if (!local) {
+      std::lock_guard<std::mutex> lg { m };
+      local = buffers.emplace_back(std::make_unique<trace_buffer>()).get();
+      local->label = local_label;
+    }
+    return *local;
+  }
+
+};
+
+/// @} End the execution Doxygen group
+
+}
+
+/*
+    # Some Emacs stuff:
+    ### Local Variables:
+    ### ispell-local-dictionary: "american"
+    ### eval: (flyspell-prog-mode)
+    ### End:
+*/
+
+#endif // TRISYCL_SYCL_DETAIL_TRACE_HPP
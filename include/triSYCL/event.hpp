@@ -8,8 +8,11 @@
     This file is distributed under the University of Illinois Open Source
     License. See LICENSE.TXT for details.
 */
+#include <coroutine>
+
 #include "triSYCL/info/event.hpp"
 #include "triSYCL/event/detail/event.hpp"
+#include "triSYCL/event/detail/future_event.hpp"
 #include "triSYCL/event/detail/host_event.hpp"
 #ifdef TRISYCL_OPENCL
 #include "triSYCL/event/detail/opencl_event.hpp"
@@ -28,6 +31,19 @@ public:
 
   event() : implementation_t { detail::host_event::instance() } {}
 
+
+  /** Construct an event tracking the execution of a task
+
+      This is an implementation detail, used by \c queue::submit
+  */
+  event(std::shared_ptr<detail::task> t)
+    : implementation_t { std::make_shared<detail::host_event>(std::move(t)) }
+  {}
+
+
+  /// Construct an event from its implementation
+  event(std::shared_ptr<detail::event> e) : implementation_t { std::move(e) } {}
+
 #ifdef TRISYCL_OPENCL
   /** Construct an event class using the clEvent from OpenCL.
 
@@ -62,9 +78,12 @@ public:
   }
 #endif
 
+  /// Return the list of events that this event waits for
   vector_class<event> get_wait_list() {
-    TRISYCL_UNIMPL;
-    return {};
+    vector_class<event> wait_list;
+    for (auto &e : implementation->get_wait_list())
+      wait_list.emplace_back(e);
+    return wait_list;
   }
 
   /** Wait for the event and the command associated with it to complete.
@@ -74,14 +93,48 @@ public:
     implementation->wait();
   }
 
+  /// Wait for all the events of a list to complete
   static void wait(const vector_class<event> &eventList) {
-    TRISYCL_UNIMPL;
+    for (auto e : eventList)
+      e.wait();
   }
 
   void wait_and_throw() {
     TRISYCL_UNIMPL;
   }
 
+
+  /** Test if a coroutine awaiting this event can go on without being
+      suspended
+
+      This makes the event awaitable with \c co_await. The events not
+      related to a task of the runtime, such as OpenCL ones, are just
+      waited for.
+  */
+  bool await_ready() {
+    auto t = implementation->get_task();
+    if (!t) {
+      wait();
+      return true;
+    }
+    return t->is_completed();
+  }
+
+
+  /** Suspend a coroutine up to the completion of the command
+
+      The coroutine is resumed by a worker of the runtime executor.
+
+      \return false if the command has already completed, so the
+      coroutine is not suspended
+  */
+  bool await_suspend(std::coroutine_handle<> h) {
+    return implementation->get_task()->add_continuation([h] { h.resume(); });
+  }
+
+
+  void await_resume() const noexcept {}
+
   static void wait_and_throw(const vector_class<event> &eventList) {
     TRISYCL_UNIMPL;
   }
@@ -9,8 +9,13 @@
     License. See LICENSE.TXT for details.
 */
 
+#include <memory>
+#include <vector>
+
 namespace trisycl::detail {
 
+struct task;
+
 struct event : detail::debug<detail::event> {
 
 public:
@@ -32,6 +37,12 @@ public:
 
   virtual void wait() const = 0;
 
+  /// Return the events this event waits for
+  virtual std::vector<std::shared_ptr<detail::event>> get_wait_list() const = 0;
+
+  /// Return the task behind the event if it belongs to the task graph
+  virtual std::shared_ptr<detail::task> get_task() const = 0;
+
   virtual ~event() {}
 };
 
@@ -0,0 +1,82 @@
+#ifndef TRISYCL_SYCL_EVENT_DETAIL_FUTURE_EVENT_HPP
+#define TRISYCL_SYCL_EVENT_DETAIL_FUTURE_EVENT_HPP
+
+/** \file An event tracking some work done by the runtime outside of
+    the task graph
+
+    This file is distributed under the University of Illinois Open Source
+    License. See LICENSE.TXT for details.
+*/
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <vector>
+
+#include "triSYCL/exception.hpp"
+
+namespace trisycl::detail {
+
+/** A host event completed when a shared future is ready
+
+    This is used for the work which is not a command of a queue, such
+    as the final write-back of a buffer.
+*/
+class future_event : public detail::event {
+
+  /// Ready when the work is done
+  std::shared_future<void> f;
+
+public:
+
+  future_event(std::shared_future<void> f) : f { std::move(f) } {}
+
+
+#ifdef TRISYCL_OPENCL
+  cl_event get() const override {
+    throw non_cl_error("The host event has no OpenCL event");
+  }
+
+  const boost::compute::event &get_boost_compute() const override {
+    throw
+      non_cl_error("The host device has no underlying Boost Compute event");
+  }
+#endif
+
+  bool is_host() const override {
+    return true;
+  }
+
+  cl_uint get_reference_count() const override {
+    return 0;
+  }
+
+  info::event_command_status get_command_execution_status() const override {
+    if (f.wait_for(std::chrono::seconds { 0 }) == std::future_status::ready)
+      return info::event_command_status::complete;
+    return info::event_command_status::running;
+  }
+
+  cl_ulong get_profiling_info(info::event_profiling) const override {
+    throw invalid_object_error {
+      "The event is not related to a command of a queue" };
+  }
+
+  void wait() const override {
+    f.wait();
+  }
+
+  /// There is no task behind this event
+  std::shared_ptr<detail::task> get_task() const override {
+    return {};
+  }
+
+  /// The work does not depend on any other event
+  std::vector<std::shared_ptr<detail::event>> get_wait_list() const override {
+    return {};
+  }
+};
+
+}
+
+#endif // TRISYCL_SYCL_EVENT_DETAIL_FUTURE_EVENT_HPP
@@ -9,14 +9,36 @@
     License. See LICENSE.TXT for details.
 */
 
+#include <memory>
+#include <vector>
+
+#include "triSYCL/command_group/detail/task.hpp"
 #include "triSYCL/detail/singleton.hpp"
+#include "triSYCL/exception.hpp"
 
 namespace trisycl::detail {
 
+/** A host event tracking the execution of a task
+
+    The singleton instance without any task is used for the events
+    not related to any command, which are always complete.
+*/
 class host_event : public detail::event,
                    public detail::singleton<host_event> {
 
+  /// The task behind this event, if any
+  std::shared_ptr<detail::task> t;
+
 public:
+
+  /// An event not related to any command
+  host_event() = default;
+
+
+  /// An event tracking the execution of a task
+  host_event(std::shared_ptr<detail::task> t) : t { std::move(t) } {}
+
+
 #ifdef TRISYCL_OPENCL
   cl_event get() const override {
     throw non_cl_error("The host event has no OpenCL event");
@@ -37,14 +59,47 @@ public:
   }
 
   info::event_command_status get_command_execution_status() const override {
+    if (!t || t->is_completed())
+      return info::event_command_status::complete;
+    if (t->is_started())
+      return info::event_command_status::running;
     return info::event_command_status::submitted;
   }
 
+  /** Get a profiling timestamp in nanoseconds
+
+      The start and end timestamps wait for the completion of the
+      command.
+  */
   cl_ulong get_profiling_info(info::event_profiling param) const override {
-    return 0;
+    if (!t || !t->profiling)
+      throw invalid_object_error {
+        "The queue was not constructed with the enable_profiling property" };
+    if (param == info::event_profiling::command_submit)
+      return t->submit_time;
+    t->wait();
+    return param == info::event_profiling::command_start ? t->start_time
+                                                         : t->end_time;
   }
 
   void wait() const override {
+    if (t)
+      t->wait();
+  }
+
+  /// Return the task behind this event, if any
+  std::shared_ptr<detail::task> get_task() const override {
+    return t;
+  }
+
+  /// Return the events of the tasks this task depends on
+  std::vector<std::shared_ptr<detail::event>> get_wait_list() const override {
+    std::vector<std::shared_ptr<detail::event>> wait_list;
+    if (t)
+      for (auto &p : t->predecessors)
+        if (auto producer = p.lock())
+          wait_list.push_back(std::make_shared<host_event>(producer));
+    return wait_list;
   }
 };
 
@@ -50,6 +50,16 @@ public:
     e.wait();
   }
 
+  /// \todo Track the OpenCL event wait list
+  std::vector<std::shared_ptr<detail::event>> get_wait_list() const override {
+    return {};
+  }
+
+  /// An OpenCL event is not part of the task graph
+  std::shared_ptr<detail::task> get_task() const override {
+    return {};
+  }
+
   /// Get a singleton instance of the \c opencl_event
   static std::shared_ptr<opencl_event>
   instance(const boost::compute::event &e) {
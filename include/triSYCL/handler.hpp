@@ -13,7 +13,10 @@
 #include <cstddef>
 #include <memory>
 #include <tuple>
+#include <type_traits>
+#include <typeinfo>
 #include <utility>
+#include <vector>
 
 #ifdef TRISYCL_OPENCL
 #include <boost/compute.hpp>
@@ -23,6 +26,7 @@
 #include "triSYCL/command_group/detail/task.hpp"
 #include "triSYCL/detail/instantiate_kernel.hpp"
 #include "triSYCL/detail/unimplemented.hpp"
+#include "triSYCL/event.hpp"
 #include "triSYCL/exception.hpp"
 #include "triSYCL/kernel.hpp"
 #include "triSYCL/opencl_types.hpp"
@@ -51,6 +55,10 @@ public:
    */
   std::shared_ptr<detail::task> task;
 
+  /** Number of iterations of a range kernel of a yielding queue
+      executed before letting the higher priority work run */
+  static constexpr std::size_t yield_chunk_size = 1 << 16;
+
 
   /* Create a command group handler from the queue detail
 
@@ -63,7 +71,38 @@ public:
   */
   handler(const std::shared_ptr<detail::queue> &q) {
     // Create a new task for this command_group
-    task = std::make_shared<detail::task>(q);
+    task = detail::task::create(q);
+  }
+
+
+  /** Make the kernel of this command group wait for the completion
+      of the command behind an event
+
+      This is useful to order commands not communicating through
+      buffers, without blocking the host.
+
+      \throw invalid_object_error if the queue is recording a command
+      graph, which cannot replay such a dependency
+  */
+  void depends_on(event e) {
+    if (task->recording)
+      throw invalid_object_error {
+        "Event dependencies cannot be recorded in a command graph" };
+    if (auto t = e.implementation->get_task())
+      task->add_producer(t);
+    else if (e.implementation->get_command_execution_status()
+             != info::event_command_status::complete)
+      /* An event outside of the task graph, such as an OpenCL one or
+         a buffer write-back, is waited for just before running the
+         kernel */
+      task->add_prelude([e] () mutable { e.wait(); });
+  }
+
+
+  /// Make the kernel wait for the completion of all the events of a list
+  void depends_on(const std::vector<event> &events) {
+    for (const auto &e : events)
+      depends_on(e);
   }
 
 
@@ -160,6 +199,34 @@ public:
 
 private:
 
+  /** Get the mangled name of a kernel for the trace, demangled when
+      the trace is written
+
+      Without a kernel name, use the type of the kernel functor, which
+      refers to the user lambda.
+  */
+  template <typename KernelName, typename Kernel>
+  static const char *kernel_trace_name() {
+#ifdef __cpp_rtti
+    if constexpr (std::is_same_v<KernelName, std::nullptr_t>)
+      return typeid(Kernel).name();
+    else {
+      // Through a pointer since the kernel name class may be incomplete
+      auto name = typeid(KernelName *).name();
+#if __has_include(<cxxabi.h>)
+      /* With the Itanium C++ ABI, the mangled name of the pointer type
+         is the one of the kernel name prefixed by P */
+      if (*name == 'P')
+        ++name;
+#endif
+      return name;
+    }
+#else
+    return nullptr;
+#endif
+  }
+
+
   /** Schedule the kernel
 
       Add a traced version of the kernel in host mode or add the
@@ -169,6 +236,7 @@ private:
   template <typename KernelName,
             typename Kernel>
   void schedule_kernel(Kernel k) {
+    task->trace_name = kernel_trace_name<KernelName, Kernel>();
     /* Explicitly capture task by copy instead of having this captured
        by reference and task by reference by side effect */
     task->schedule(detail::trace_kernel<KernelName>([=, t = task] () mutable {
@@ -185,6 +253,25 @@ private:
         }));
   }
 
+  /** Execute a range kernel of a yielding queue from the linearized
+      index \p begin
+
+      When some more urgent work is ready between 2 chunks, the rest
+      of the kernel is left to the task to be resumed later at the
+      priority of the queue.
+  */
+  template <int Dims, typename ParallelForFunctor>
+  static void run_yielding(detail::task *t, const range<Dims> &global_size,
+                           ParallelForFunctor f, std::size_t begin) {
+    auto priority = t->owner_queue->get_priority();
+    auto next = detail::parallel_for_yielding(global_size, f, begin,
+                                              yield_chunk_size, [=] {
+        return detail::executor::instance()->has_higher_priority(priority);
+      });
+    if (next != global_size.size())
+      t->resumption = [=] { run_yielding(t, global_size, f, next); };
+  }
+
   /** Schedule a parallel for kernel
 
       \todo Add host fall-back execution for parallel_for_kernel
@@ -197,6 +284,7 @@ private:
             typename Kernel,
             int N>
   void schedule_parallel_for_kernel(Kernel k, const range<N> &num_work_items) {
+    task->trace_name = kernel_trace_name<KernelName, Kernel>();
     task->schedule(detail::trace_kernel<KernelName>([=, t = task] () mutable {
           // if (t->owner_queue->is_host())
              // k();
@@ -235,6 +323,26 @@ public:
   }
 
 
+  /** Execute some host code as a command of the task graph
+
+      Unlike with a host accessor, the submitting thread is not
+      blocked: the callable is run by the runtime workers once all the
+      dependencies of the command group are satisfied, so some host
+      work like I/O can overlap with the kernels.
+
+      The buffers are accessed from the callable through some
+      accessors with the access::target::host_task target.
+
+      \param f is the callable to execute, taking no argument
+  */
+  template <typename HostFunctor>
+  void host_task(HostFunctor &&f) {
+    TRISYCL_DUMP_T("host_task &f = " << (void *) &f);
+    task->trace_name = kernel_trace_name<std::nullptr_t, HostFunctor>();
+    task->schedule([f = std::forward<HostFunctor>(f)] () mutable { f(); });
+  }
+
+
   /** SYCL parallel_for launches a data parallel computation with
       parallelism specified at launch time by a range<>
 
@@ -266,10 +374,26 @@ public:
       // Use a normal parallel for
       schedule_parallel_for_kernel<KernelName>(
           [=] { detail::parallel_for(global_size, f); }, global_size);
-    } else
-      // Launch a single-task kernel containing the loop nests
-      schedule_kernel<KernelName>(
+    } else {
+      if (task->recording && task->owner_queue->fusable_recording) {
+        /* Keep also a chunked version of the kernel to be fused with
+           the next kernels of the command graph */
+        task->fusable_extents.assign(global_size.begin(), global_size.end());
+        task->fusable_kernel = [=] (std::size_t begin,
+                                    std::size_t end) mutable {
+          detail::parallel_for_linear_chunk(global_size, f, begin, end);
+        };
+      }
+      if (task->owner_queue->is_yielding())
+        // Let the higher priority work run between chunks of the kernel
+        schedule_kernel<KernelName>([=, t = task.get()] {
+            run_yielding(t, global_size, f, 0);
+          });
+      else
+        // Launch a single-task kernel containing the loop nests
+        schedule_kernel<KernelName>(
           [=] { detail::parallel_for(global_size, f); });
+    }
   }
 
   /** SYCL parallel_for launches a data parallel computation with
@@ -531,8 +655,11 @@ namespace detail {
 static std::shared_ptr<detail::task>
 add_buffer_to_task(handler *command_group_handler,
                    std::shared_ptr<detail::buffer_base> b,
-                   bool is_write_mode) {
-  command_group_handler->task->add_buffer(b, is_write_mode);
+                   bool is_write_mode,
+                   bool is_discard_mode,
+                   const buffer_region &r) {
+  command_group_handler->task->add_buffer(b, is_write_mode, is_discard_mode,
+                                          r);
   return command_group_handler->task;
 }
 
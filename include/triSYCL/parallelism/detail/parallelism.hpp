@@ -13,7 +13,9 @@
     License. See LICENSE.TXT for details.
 */
 
+#include <algorithm>
 #include <cstddef>
+#include <type_traits>
 
 #include "triSYCL/group.hpp"
 #include "triSYCL/h_item.hpp"
@@ -227,6 +229,116 @@ void parallel_for(range<Dimensions> r, ParallelForFunctor f) {
 #endif
 
 
+/** Execute a range kernel on a contiguous chunk of the linearized
+    iteration space, in row-major order
+
+    This is used to interleave several kernels on the same iteration
+    space chunk by chunk.
+*/
+template <int Dimensions = 1, typename ParallelForFunctor>
+void parallel_for_linear_chunk(range<Dimensions> r,
+                               ParallelForFunctor &f,
+                               std::size_t begin,
+                               std::size_t end) {
+  using index_type = decltype(capture_arg_v(&ParallelForFunctor::operator()));
+  if (begin == end)
+    return;
+  // Only the first index of the chunk is delinearized
+  id<Dimensions> index;
+  auto remaining = begin;
+  for (int d = Dimensions - 1; d >= 0; --d) {
+    index[d] = remaining % r[d];
+    remaining /= r[d];
+  }
+  for (auto linear = begin;;) {
+    if constexpr (std::is_same_v<index_type, item<Dimensions>>)
+      f(item<Dimensions> { r, index });
+    else
+      f(index);
+    if (++linear == end)
+      return;
+    // Then increment the index with a carry to the outer dimensions
+    for (int d = Dimensions - 1; ++index[d] == r[d] && d > 0; --d)
+      index[d] = 0;
+  }
+}
+
+
+/** Execute a sequence of kernels on the same linearized iteration
+    space, one chunk at a time
+
+    Each chunk is processed by all the kernels in sequence while it is
+    still in the cache.
+
+    \param[in] count is the size of the iteration space
+
+    \param[in] kernels is the sequence of kernels to call on the
+    [begin, end) chunks of the iteration space
+
+    \param[in] chunk_size is the number of iterations of a chunk
+*/
+template <typename ChunkKernels>
+void parallel_for_fused(std::size_t count,
+                        const ChunkKernels &kernels,
+                        std::size_t chunk_size) {
+  std::size_t chunks = (count + chunk_size - 1)/chunk_size;
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for (std::size_t c = 0; c < chunks; ++c) {
+    auto begin = c*chunk_size;
+    auto end = std::min(count, begin + chunk_size);
+    for (const auto &k : kernels)
+      k(begin, end);
+  }
+}
+
+
+/** Execute a range kernel chunk by chunk, stopping between the chunks
+    when asked to
+
+    This allows a long kernel to yield to some more urgent work and to
+    be resumed later.
+
+    \param[in] r is the iteration space
+
+    \param[in] f is the kernel
+
+    \param[in] begin is the linearized index of the first iteration to
+    execute
+
+    \param[in] chunk_size is the number of iterations between 2 tests
+    of \p should_yield
+
+    \param[in] should_yield returns true to stop the execution before
+    the next chunk
+
+    \return the linearized index of the first iteration not executed,
+    which is the iteration count if the kernel has completed
+*/
+template <int Dimensions = 1, typename ParallelForFunctor, typename Yield>
+std::size_t parallel_for_yielding(range<Dimensions> r,
+                                  ParallelForFunctor &f,
+                                  std::size_t begin,
+                                  std::size_t chunk_size,
+                                  Yield should_yield) {
+  // The granularity of the work distribution inside a chunk
+  constexpr std::size_t sub_chunk_size = 1024;
+  auto count = r.size();
+  for (auto first = begin; begin < count; begin += chunk_size) {
+    if (begin != first && should_yield())
+      return begin;
+    auto end = std::min(count, begin + chunk_size);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (std::size_t b = begin; b < end; b += sub_chunk_size)
+      parallel_for_linear_chunk(r, f, b, std::min(end, b + sub_chunk_size));
+  }
+  return count;
+}
+
+
 /** Implementation of parallel_for with a range<> and an offset */
 template <int Dimensions = 1, typename ParallelForFunctor>
 void parallel_for_global_offset(range<Dimensions> global_size,
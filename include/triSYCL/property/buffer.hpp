@@ -0,0 +1,71 @@
+#ifndef TRISYCL_SYCL_PROPERTY_BUFFER_HPP
+#define TRISYCL_SYCL_PROPERTY_BUFFER_HPP
+
+/** \file Properties for buffer objects.
+
+    This file is distributed under the University of Illinois Open Source
+    License. See LICENSE.TXT for details.
+*/
+
+#include <cstddef>
+
+#include "triSYCL/exception.hpp"
+
+namespace trisycl::property::buffer {
+
+/** Align the storage allocated by the runtime for the buffer
+
+    Kernels can then use \c accessor::get_aligned_pointer() to tell
+    the compiler about it, for example for aligned SIMD loads, except
+    on the sub-buffers.
+
+    It cannot be combined with a user allocator type.
+
+    This is a triSYCL extension.
+*/
+class alignment : public detail::property {
+public:
+  /// \param[in] bytes is the alignment, a power of 2
+  alignment(std::size_t bytes)
+    : bytes { bytes } {
+    if (bytes == 0 || (bytes & (bytes - 1)) != 0)
+      throw invalid_parameter_error {
+        "The buffer alignment has to be a power of 2" };
+  }
+
+  /// Get the alignment in bytes
+  std::size_t get_alignment() const { return bytes; }
+
+private:
+  std::size_t bytes;
+};
+
+/** Back the storage allocated by the runtime for a large buffer with
+    huge pages when the system allows it, to reduce the TLB misses
+
+    It cannot be combined with a user allocator type.
+
+    This is a triSYCL extension.
+*/
+class use_huge_pages : public detail::property {
+public:
+  use_huge_pages() {}
+};
+
+/** Do not block on the destruction of the buffer while it is still
+    used by some kernels or has to write its data back
+
+    The last kernel using the buffer does the final write-back
+    instead. Use \c buffer::get_write_back_event() to know when the
+    data are available.
+
+    This is a triSYCL extension.
+*/
+class detach_on_destroy : public detail::property {
+public:
+  detach_on_destroy() {}
+};
+
+}
+
+#endif // TRISYCL_SYCL_PROPERTY_BUFFER_HPP
@@ -15,6 +15,48 @@ public:
   enable_profiling() {}
 };
 
+/** Execute the command groups of the queue in submission order
+
+    The command groups of such a queue only depend on the previous one
+    of the queue and on the command groups of other queues.
+*/
+class in_order : public detail::property {
+public:
+  in_order() {}
+};
+
+/** Set the priority of the command groups of the queue on the host
+    device
+
+    The ready command groups of higher priority queues are started
+    first.
+
+    A low-priority queue can also ask its long range kernels to yield
+    between chunks of their iteration space when some command groups
+    of higher priority are ready. The rest of such a kernel is then
+    resumed later by a worker, like any other ready work of its
+    priority.
+*/
+class priority : public detail::property {
+public:
+  /// The priority levels
+  enum level : unsigned int { low, normal, high };
+
+  priority(level l, bool yielding = false)
+    : l { l }
+    , yielding { yielding } {}
+
+  /// Get the priority level
+  level get_level() const { return l; }
+
+  /// Test if the range kernels yield to the higher priority work
+  bool is_yielding() const { return yielding; }
+
+private:
+  level l;
+  bool yielding;
+};
+
 }
 
 #endif // TRISYCL_SYCL_PROPERTY_QUEUE_HPP
@@ -4,6 +4,8 @@
 #include <optional>
 
 #include "triSYCL/detail/all_true.hpp"
+#include "triSYCL/detail/property.hpp"
+#include "triSYCL/property/buffer.hpp"
 #include "triSYCL/property/queue.hpp"
 
 namespace trisycl {
@@ -19,7 +21,12 @@ class property_list {
    * and the addproperty methods init the correct one for each known
    * property, this method is recursive to deal with the pack parameter.
    */
+  TRISYCL_PROPERTY_CREATE(buffer, alignment);
+  TRISYCL_PROPERTY_CREATE(buffer, detach_on_destroy);
+  TRISYCL_PROPERTY_CREATE(buffer, use_huge_pages);
   TRISYCL_PROPERTY_CREATE(queue, enable_profiling);
+  TRISYCL_PROPERTY_CREATE(queue, in_order);
+  TRISYCL_PROPERTY_CREATE(queue, priority);
 
 protected:
   template <typename propertyT>
@@ -33,8 +40,12 @@ private:
   template<typename T, typename... propsT,
            typename = std::enable_if_t<detail::all_true<std::is_convertible<propsT, detail::property>::value ...>::value>>
   void addproperty(T first, propsT... next) {
+    addproperty(first);
     addproperty(next...);
   }
+
+  /// End the recursion on the pack parameter
+  void addproperty() {}
 public:
   /** Construct a property list from a list of classes derived from the detail::property.
 
@@ -62,7 +73,12 @@ public:
     return prop_name.value();                                           \
   }
 
+TRISYCL_PROPERTY_HAS_GET(buffer, alignment)
+TRISYCL_PROPERTY_HAS_GET(buffer, detach_on_destroy)
+TRISYCL_PROPERTY_HAS_GET(buffer, use_huge_pages)
 TRISYCL_PROPERTY_HAS_GET(queue, enable_profiling)
+TRISYCL_PROPERTY_HAS_GET(queue, in_order)
+TRISYCL_PROPERTY_HAS_GET(queue, priority)
 
 #undef TRISYCL_PROPERTY_CREATE
 #undef TRISYCL_PROPERTY_HAS_GET
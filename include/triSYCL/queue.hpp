@@ -10,11 +10,13 @@
 */
 
 #include <memory>
+#include <utility>
 
 #ifdef TRISYCL_OPENCL
 #include <boost/compute.hpp>
 #endif
 
+#include "triSYCL/command_graph.hpp"
 #include "triSYCL/context.hpp"
 #include "triSYCL/detail/debug.hpp"
 #include "triSYCL/detail/default_classes.hpp"
@@ -22,6 +24,7 @@
 #include "triSYCL/detail/property.hpp"
 #include "triSYCL/device.hpp"
 #include "triSYCL/device_selector.hpp"
+#include "triSYCL/event.hpp"
 #include "triSYCL/exception.hpp"
 #include "triSYCL/handler.hpp"
 #include "triSYCL/info/param_traits.hpp"
@@ -135,7 +138,9 @@ public:
 #else
     new detail::host_queue
 #endif
-  }, property_list { propList } { }
+  }, property_list { propList } {
+    apply_properties();
+  }
 
   /** A queue is created for a SYCL device
 
@@ -171,6 +176,7 @@ public:
 #else
     std::shared_ptr<detail::queue>{ new detail::host_queue };
 #endif
+    apply_properties();
   }
 
   /** This constructor chooses a device based on the provided
@@ -320,7 +326,75 @@ public:
   event submit(Handler_Functor cgf) {
     handler command_group_handler { implementation };
     cgf(command_group_handler);
-    return {};
+    if (implementation->is_recording()) {
+      implementation->recording->record(*command_group_handler.task);
+      // The command group will be executed only by a replay
+      return {};
+    }
+    if (!command_group_handler.task->is_scheduled())
+      // Without any kernel, there is nothing to wait for
+      return {};
+    return { command_group_handler.task };
+  }
+
+
+  /** Start recording the command groups submitted to this queue into
+      a command graph instead of executing them
+
+      \param[in] fusable keeps also a chunked version of the range
+      kernels, so that they can be fused later with \c
+      command_graph::fuse()
+
+      This is a triSYCL extension
+  */
+  void begin_recording(bool fusable = false) {
+    if (implementation->is_recording())
+      throw invalid_object_error { "The queue is already recording" };
+    implementation->recording =
+      std::make_shared<detail::command_graph>(implementation);
+    implementation->fusable_recording = fusable;
+  }
+
+
+  /** Stop recording the command groups submitted to this queue
+
+      \return the command graph of the command groups submitted since
+      \c begin_recording(), ready to be replayed
+
+      This is a triSYCL extension
+  */
+  trisycl::command_graph end_recording() {
+    if (!implementation->is_recording())
+      throw invalid_object_error { "The queue is not recording" };
+    return { std::exchange(implementation->recording, nullptr) };
+  }
+
+
+  /** Start recording the command groups submitted to this queue to
+      fuse their kernels
+
+      This is a triSYCL extension
+  */
+  void start_fusion() {
+    begin_recording(true);
+  }
+
+
+  /** Execute the command groups submitted since \c start_fusion(),
+      with the consecutive range kernels on the same iteration space
+      fused into a single sweep
+
+      The user asserts that these kernels access the buffers they
+      share elementwise, see \c command_graph::fuse()
+
+      \return an event tracking the execution of all the command groups
+
+      This is a triSYCL extension
+  */
+  event complete_fusion() {
+    auto g = end_recording();
+    g.fuse();
+    return g.replay();
   }
 
 
@@ -355,6 +429,20 @@ public:
   propertyT get_property() const {
     return property_list::get_property<propertyT>();
   }
+
+private:
+
+  /// Configure the implementation according to the queue properties
+  void apply_properties() {
+    if (has_property<property::queue::enable_profiling>())
+      implementation->enable_profiling();
+    if (has_property<property::queue::in_order>())
+      implementation->enable_in_order();
+    if (has_property<property::queue::priority>()) {
+      auto p = get_property<property::queue::priority>();
+      implementation->set_priority(p.get_level(), p.is_yielding());
+    }
+  }
 };
 
 template<>
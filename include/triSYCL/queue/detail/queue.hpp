@@ -10,7 +10,8 @@
 */
 
 #include <atomic>
-#include <condition_variable>
+#include <deque>
+#include <memory>
 #include <mutex>
 
 #ifdef TRISYCL_OPENCL
@@ -19,32 +20,178 @@
 
 #include "triSYCL/context.hpp"
 #include "triSYCL/device.hpp"
+#include "triSYCL/detail/atomic_wait.hpp"
 #include "triSYCL/detail/debug.hpp"
+#include "triSYCL/detail/executor.hpp"
+#include "triSYCL/detail/recycling_allocator.hpp"
 
 namespace trisycl::detail {
 
+struct command_graph;
+struct task;
+
 /** Some implementation details about the SYCL queue
  */
-struct queue : detail::debug<detail::queue> {
+struct queue : std::enable_shared_from_this<detail::queue>,
+               detail::debug<detail::queue> {
   /// Track the number of kernels still running to wait for their completion
   std::atomic<size_t> running_kernels;
 
-  /// To signal when all the kernels have completed
-  std::condition_variable finished;
-  /// To protect the access to the condition variable
-  std::mutex finished_mutex;
+  /// Number of threads waiting for all the kernels to complete
+  std::atomic<std::size_t> waiters = 0;
+
+
+  /// Record the execution timestamps of the kernels
+  std::atomic<bool> profiling = false;
+
+  /// Execute the command groups in submission order
+  std::atomic<bool> in_order = false;
+
+  /// The executor priority level of the command groups
+  std::size_t priority = detail::executor::normal_priority;
+
+  /// Ask the range kernels to yield to the higher priority work
+  bool yielding = false;
+
+  /// The latest task submitted to an in-order queue
+  std::weak_ptr<detail::task> last_task;
+
+  /** The work ready to be executed back-to-back for an in-order
+      queue */
+  std::deque<detail::executor::work> serial_ready;
 
+  /// Track if a worker is executing the work of an in-order queue
+  bool serial_running = false;
+
+  /// To protect the in-order execution state
+  std::mutex serial_mutex;
+
+  /** The command graph recording the command groups submitted to the
+      queue, if any
+
+      The recording is not thread-safe and the command groups are
+      expected to be submitted from a single thread while recording
+  */
+  std::shared_ptr<detail::command_graph> recording;
+
+  /** Keep also a fusable version of the range kernels recorded into
+      the command graph */
+  bool fusable_recording = false;
+
+  /** The memory of the completed tasks of the queue, recycled for the
+      next command groups */
+  std::shared_ptr<detail::recycling_pool> task_pool =
+    std::make_shared<detail::recycling_pool>();
 
   /// Initialize the queue with 0 running kernel
   queue() : running_kernels { 0 } {}
 
+
+  /// Ask to record the execution timestamps of the kernels
+  void enable_profiling() {
+    profiling = true;
+  }
+
+
+  /// Get an allocator recycling the memory of the tasks of the queue
+  detail::recycling_allocator<std::byte> get_task_allocator() const {
+    return { task_pool };
+  }
+
+
+  /// Test if the execution timestamps of the kernels are recorded
+  bool is_profiling_enabled() const {
+    return profiling;
+  }
+
+
+  /// Test if the command groups are recorded into a command graph
+  bool is_recording() const {
+    return static_cast<bool>(recording);
+  }
+
+
+  /// Ask to execute the command groups in submission order
+  void enable_in_order() {
+    in_order = true;
+  }
+
+
+  /// Test if the command groups are executed in submission order
+  bool is_in_order() const {
+    return in_order;
+  }
+
+
+  /** Set the priority level of the command groups
+
+      \param[in] level is the executor priority level
+
+      \param[in] yield asks the range kernels to run the ready work of
+      higher priority between chunks of their iteration space
+  */
+  void set_priority(std::size_t level, bool yield) {
+    priority = level;
+    yielding = yield;
+  }
+
+
+  /// Get the executor priority level of the command groups
+  std::size_t get_priority() const {
+    return priority;
+  }
+
+
+  /// Test if the range kernels yield to the higher priority work
+  bool is_yielding() const {
+    return yielding;
+  }
+
+
+  /** Set the latest task submitted to an in-order queue
+
+      \return the previous one, if it still exists
+  */
+  std::shared_ptr<detail::task>
+  set_last_task(std::weak_ptr<detail::task> newer_last_task) {
+    std::lock_guard<std::mutex> lg { serial_mutex };
+    using std::swap;
+
+    swap(newer_last_task, last_task);
+    return newer_last_task.lock();
+  }
+
+
+  /** Execute some ready work of the queue
+
+      The work of an in-order queue is executed back-to-back by a
+      single worker at a time, since it is serialized anyway.
+  */
+  void dispatch(detail::executor::work work) {
+    if (!in_order) {
+      detail::executor::instance()->submit(std::move(work), priority);
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lg { serial_mutex };
+      serial_ready.push_back(std::move(work));
+      if (serial_running)
+        // The worker already draining the queue will execute it
+        return;
+      serial_running = true;
+    }
+    // Keep the queue alive while draining it
+    detail::executor::instance()->submit([q = shared_from_this()] {
+      q->run_serial();
+    }, priority);
+  }
+
   /// Wait for all kernel completion
   void wait_for_kernel_execution() {
     TRISYCL_DUMP_T("Queue waiting for kernel completion");
-    std::unique_lock<std::mutex> ul { finished_mutex };
-    finished.wait(ul, [&] {
+    detail::wait_until(running_kernels, waiters, [] (std::size_t running) {
         // When there is no kernel running in this queue, we are ready to go
-        return running_kernels == 0;
+        return running == 0;
       });
   }
 
@@ -57,14 +204,28 @@ struct queue : detail::debug<detail::queue> {
   }
 
 
+  /// Execute the ready work of an in-order queue up to exhaustion
+  void run_serial() {
+    for (;;) {
+      detail::executor::work work;
+      {
+        std::lock_guard<std::mutex> lg { serial_mutex };
+        if (serial_ready.empty()) {
+          serial_running = false;
+          return;
+        }
+        work = std::move(serial_ready.front());
+        serial_ready.pop_front();
+      }
+      work();
+    }
+  }
+
+
   /// Signal that a new kernel finished on this queue
   void kernel_end() {
     TRISYCL_DUMP_T("A kernel of the queue ended");
-    std::unique_lock<std::mutex> ul { finished_mutex };
     if (--running_kernels == 0) {
-      // Micro-optimization: unlock before the notification
-      // https://en.cppreference.com/w/cpp/thread/condition_variable/notify_all
-      ul.unlock();
       /* It was the last kernel running, so signal the queue just in
          case it was working for it for completion
 
@@ -72,7 +233,7 @@ struct queue : detail::debug<detail::queue> {
          same queue, because of this \c notify_one is not be enough
          and a \c notify_all is needed
       */
-      finished.notify_all();
+      detail::notify_waiters(running_kernels, waiters);
     }
   }
 
@@ -52,6 +52,7 @@
 #include "triSYCL/allocator.hpp"
 #include "triSYCL/address_space.hpp"
 #include "triSYCL/buffer.hpp"
+#include "triSYCL/command_graph.hpp"
 #include "triSYCL/context.hpp"
 #include "triSYCL/device.hpp"
 #include "triSYCL/device_runtime.hpp"
@@ -0,0 +1,77 @@
+/* RUN: %{execute}%s
+
+   Test the ordering of the kernels from the access history of buffers
+*/
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+/// Test explicitly a feature of triSYCL, so include the triSYCL header
+#include "triSYCL/sycl.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace trisycl;
+
+// To have access to handy C++14 units, like in 1ms
+using namespace std::literals;
+
+TEST_CASE("independent readers run concurrently", "[buffer]") {
+  int v = 42;
+  constexpr auto readers = 3;
+  std::atomic<int> running = 0;
+  {
+    buffer<int> b { &v, 1 };
+    queue q;
+
+    for (int i = 0; i != readers; ++i)
+      q.submit([&] (handler &cgh) {
+          auto a = b.get_access<access::mode::read>(cgh);
+          cgh.single_task([=, &running] {
+              ++running;
+              // Wait for all the readers to be running at the same time
+              while (running != readers)
+                std::this_thread::sleep_for(1ms);
+            });
+        });
+    // The readers do not depend on each other, so they could all wait
+    q.wait();
+  }
+  REQUIRE(running == readers);
+}
+
+TEST_CASE("a writer waits for the previous readers", "[buffer]") {
+  int v = 1;
+  int r1 = 0, r2 = 0;
+  {
+    buffer<int> b { &v, 1 };
+    buffer<int> br1 { &r1, 1 };
+    buffer<int> br2 { &r2, 1 };
+    queue q;
+
+    // 2 slow readers
+    for (auto br : { &br1, &br2 })
+      q.submit([&] (handler &cgh) {
+          auto a = b.get_access<access::mode::read>(cgh);
+          auto r = br->get_access<access::mode::write>(cgh);
+          cgh.single_task([=] {
+              std::this_thread::sleep_for(50ms);
+              r[0] = a[0];
+            });
+        });
+    // The writer must not change the value under the readers feet
+    q.submit([&] (handler &cgh) {
+        auto a = b.get_access<access::mode::write>(cgh);
+        cgh.single_task([=] { a[0] = 2; });
+      });
+    // The next reader sees the written value
+    q.submit([&] (handler &cgh) {
+        auto a = b.get_access<access::mode::read_write>(cgh);
+        cgh.single_task([=] { a[0] *= 10; });
+      });
+  }
+  REQUIRE(r1 == 1);
+  REQUIRE(r2 == 1);
+  REQUIRE(v == 20);
+}
@@ -0,0 +1,88 @@
+/* RUN: %{execute}%s
+
+   Test the alignment of the buffer storage requested with properties
+*/
+
+#include <cstdint>
+#include <vector>
+
+/// Test explicitly a feature of triSYCL, so include the triSYCL header
+#include "triSYCL/sycl.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace trisycl;
+
+/// Test if a pointer is aligned on some bytes
+bool is_aligned(const void *p, std::size_t alignment) {
+  return reinterpret_cast<std::uintptr_t>(p) % alignment == 0;
+}
+
+TEST_CASE("cache-line aligned buffer", "[buffer]") {
+  constexpr std::size_t N = 1000;
+  buffer<float> b { range<1> { N }, { property::buffer::alignment { 64 } } };
+  REQUIRE(b.has_property<property::buffer::alignment>());
+  REQUIRE(b.get_property<property::buffer::alignment>().get_alignment()
+          == 64);
+  REQUIRE(!b.has_property<property::buffer::use_huge_pages>());
+  queue q;
+  q.submit([&] (handler &cgh) {
+      auto a = b.get_access<access::mode::discard_write>(cgh);
+      cgh.single_task([=] {
+          auto p = a.get_aligned_pointer<64>();
+          for (std::size_t i = 0; i != N; ++i)
+            p[i] = i;
+        });
+    });
+  auto a = b.get_access<access::mode::read>();
+  REQUIRE(is_aligned(a.get_pointer(), 64));
+  REQUIRE(a[N - 1] == N - 1);
+}
+
+TEST_CASE("huge page backed buffer", "[buffer]") {
+  // Large enough to use huge pages
+  constexpr std::size_t N = 1 << 20;
+  std::vector<int> v(N, 3);
+  buffer<int> b { v.begin(), v.end(), { property::buffer::use_huge_pages {} } };
+  auto a = b.get_access<access::mode::read>();
+  REQUIRE(is_aligned(a.get_pointer(), 2 << 20));
+  REQUIRE(a[N - 1] == 3);
+}
+
+TEST_CASE("copy-on-write of aligned read-only data", "[buffer]") {
+  alignas(64) static const float init[16] = { 1, 2, 3 };
+  buffer<float> b { init, 16, { property::buffer::alignment { 64 } } };
+  {
+    auto a = b.get_access<access::mode::read_write>();
+    a[0] = 5;
+    // The storage created by the copy-on-write is aligned too
+    REQUIRE(is_aligned(a.get_pointer(), 64));
+  }
+  REQUIRE(init[0] == 1);
+}
+
+TEST_CASE("invalid alignments", "[buffer]") {
+  REQUIRE_THROWS_AS(property::buffer::alignment { 63 },
+                    invalid_parameter_error);
+  REQUIRE_THROWS_AS(property::buffer::alignment { 0 },
+                    invalid_parameter_error);
+  alignas(64) float v[17];
+  // Host memory which is not aligned enough
+  REQUIRE_THROWS_AS((buffer<float> { v + 1, 16,
+                                     { property::buffer::alignment { 64 } } }),
+                    invalid_parameter_error);
+  buffer<float> b { v, 16, { property::buffer::alignment { 64 } } };
+  REQUIRE(b.has_property<property::buffer::alignment>());
+}
+
+TEST_CASE("alignment with a user allocator", "[buffer]") {
+  using pooled_buffer = buffer<float, 1, pooled_buffer_allocator<float>>;
+  REQUIRE_THROWS_AS((pooled_buffer { range<1> { 16 }, {},
+                                     { property::buffer::alignment { 64 } } }),
+                    invalid_parameter_error);
+  REQUIRE_THROWS_AS((pooled_buffer { range<1> { 16 }, {},
+                                     { property::buffer::use_huge_pages {} } }),
+                    invalid_parameter_error);
+  pooled_buffer b { range<1> { 16 } };
+  REQUIRE(!b.has_property<property::buffer::alignment>());
+}
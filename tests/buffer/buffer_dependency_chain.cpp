@@ -0,0 +1,84 @@
+/* RUN: %{execute}%s
+
+   Test that kernels waiting for their producers do not use any thread
+*/
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+/// Test explicitly a feature of triSYCL, so include the triSYCL header
+#include "triSYCL/sycl.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace trisycl;
+
+// To have access to handy C++14 units, like in 1ms
+using namespace std::literals;
+
+// Length of the kernel pipeline
+constexpr auto N = 1000;
+
+TEST_CASE("a deep pipeline of kernels runs in order", "[task]") {
+  int v = 0;
+  {
+    buffer<int> b { &v, 1 };
+    queue q;
+    std::atomic<bool> go = false;
+
+    // The head of the pipeline blocks until all the kernels are submitted
+    q.submit([&] (handler &cgh) {
+        auto a = b.get_access<access::mode::write>(cgh);
+        cgh.single_task([=, &go] {
+            while (!go)
+              std::this_thread::sleep_for(1ms);
+            a[0] = 0;
+          });
+      });
+    auto workers = detail::executor::instance()->size();
+    for (int i = 0; i != N; ++i)
+      q.submit([&] (handler &cgh) {
+          auto a = b.get_access<access::mode::read_write>(cgh);
+          // Each kernel checks it runs after the previous one
+          cgh.single_task([=] { a[0] = a[0] == i ? i + 1 : -1; });
+        });
+    // Leave some time to the executor to add workers if it starves
+    std::this_thread::sleep_for(100ms);
+    // The pending kernels are not parked on some threads
+    REQUIRE(detail::executor::instance()->size() == workers);
+    go = true;
+    q.wait();
+  }
+  REQUIRE(v == N);
+}
+
+TEST_CASE("a kernel runs after all its producers", "[task]") {
+  int x = 0, y = 0, z = 0;
+  {
+    buffer<int> bx { &x, 1 };
+    buffer<int> by { &y, 1 };
+    buffer<int> bz { &z, 1 };
+    queue q;
+
+    q.submit([&] (handler &cgh) {
+        auto a = bx.get_access<access::mode::write>(cgh);
+        cgh.single_task([=] {
+            std::this_thread::sleep_for(50ms);
+            a[0] = 3;
+          });
+      });
+    q.submit([&] (handler &cgh) {
+        auto a = by.get_access<access::mode::write>(cgh);
+        cgh.single_task([=] { a[0] = 4; });
+      });
+    // The join of the diamond depends on the 2 previous kernels
+    q.submit([&] (handler &cgh) {
+        auto a = bx.get_access<access::mode::read>(cgh);
+        auto b = by.get_access<access::mode::read>(cgh);
+        auto c = bz.get_access<access::mode::write>(cgh);
+        cgh.single_task([=] { c[0] = a[0]*b[0]; });
+      });
+  }
+  REQUIRE(z == 12);
+}
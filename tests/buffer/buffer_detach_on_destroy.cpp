@@ -0,0 +1,117 @@
+/* RUN: %{execute}%s
+
+   Test the buffers which do not wait for the write-back on destruction
+*/
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/// Test explicitly a feature of triSYCL, so include the triSYCL header
+#include "triSYCL/sycl.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace trisycl;
+
+constexpr size_t N = 16;
+
+TEST_CASE("detached buffer destruction does not wait", "[buffer]") {
+  int v[N] = {};
+  std::atomic<bool> go = false;
+  std::atomic<std::size_t> waiters = 0;
+  queue q;
+  event e;
+  {
+    buffer<int> b { v, N, { property::buffer::detach_on_destroy {} } };
+    REQUIRE(b.has_property<property::buffer::detach_on_destroy>());
+    e = b.get_write_back_event();
+    q.submit([&] (handler &cgh) {
+        auto a = b.get_access<access::mode::write>(cgh);
+        cgh.single_task([=, &go, &waiters] {
+            // Only finish once the buffer has been destroyed
+            detail::wait_until(go, waiters, [] (bool g) { return g; });
+            for (int i = 0; i != N; ++i)
+              a[i] = i;
+          });
+      });
+    /* The kernel cannot complete before the end of this scope, so a
+       blocking destruction would dead-lock here */
+  }
+  // The kernel is still blocked, so the data are not written back yet
+  REQUIRE(e.get_info<info::event::command_execution_status>()
+          != info::event_command_status::complete);
+  go = true;
+  detail::notify_waiters(go, waiters);
+  e.wait();
+  REQUIRE(e.get_info<info::event::command_execution_status>()
+          == info::event_command_status::complete);
+  for (int i = 0; i != N; ++i)
+    REQUIRE(v[i] == i);
+}
+
+TEST_CASE("detached buffer final data", "[buffer]") {
+  std::vector<int> in(N, 1);
+  std::vector<int> out(N);
+  queue q;
+  event e;
+  {
+    buffer<int> b { in.begin(), in.end(),
+                    { property::buffer::detach_on_destroy {} } };
+    b.set_final_data(out.begin());
+    e = b.get_write_back_event();
+    q.submit([&] (handler &cgh) {
+        auto a = b.get_access<access::mode::read_write>(cgh);
+        cgh.parallel_for(range<1> { N }, [=] (id<1> i) { a[i] += i[0]; });
+      });
+  }
+  e.wait();
+  for (int i = 0; i != N; ++i)
+    REQUIRE(out[i] == i + 1);
+}
+
+TEST_CASE("blocking buffer write-back event", "[buffer]") {
+  int v = 0;
+  event e;
+  {
+    buffer<int> b { &v, 1 };
+    e = b.get_write_back_event();
+    queue {}.submit([&] (handler &cgh) {
+        auto a = b.get_access<access::mode::write>(cgh);
+        cgh.single_task([=] { a[0] = 42; });
+      });
+  }
+  // The destruction has waited for the write-back
+  REQUIRE(e.get_info<info::event::command_execution_status>()
+          == info::event_command_status::complete);
+  REQUIRE(v == 42);
+}
+
+TEST_CASE("a kernel depends on the write-back of a detached buffer",
+          "[buffer]") {
+  int v = 0;
+  std::atomic<bool> go = false;
+  std::atomic<std::size_t> waiters = 0;
+  queue q;
+  event written_back;
+  {
+    buffer<int> b { &v, 1, { property::buffer::detach_on_destroy {} } };
+    written_back = b.get_write_back_event();
+    q.submit([&] (handler &cgh) {
+        auto a = b.get_access<access::mode::write>(cgh);
+        cgh.single_task([=, &go, &waiters] {
+            detail::wait_until(go, waiters, [] (bool g) { return g; });
+            a[0] = 6;
+          });
+      });
+  }
+  int seen = 0;
+  auto e = q.submit([&] (handler &cgh) {
+      cgh.depends_on(written_back);
+      cgh.single_task([&] { seen = v; });
+    });
+  go = true;
+  detail::notify_waiters(go, waiters);
+  e.wait();
+  REQUIRE(seen == 6);
+}
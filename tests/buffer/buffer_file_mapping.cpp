@@ -0,0 +1,128 @@
+/* RUN: %{execute}%s
+
+   Test buffers backed by a file mapped in memory
+*/
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+/// Test explicitly a feature of triSYCL, so include the triSYCL header
+#include "triSYCL/sycl.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace trisycl;
+
+constexpr std::size_t N = 10000;
+
+/// Create a file with the integers from 0 to N - 1
+std::filesystem::path make_file(const char *name) {
+  auto path = std::filesystem::temp_directory_path() / name;
+  std::vector<int> v(N);
+  std::iota(v.begin(), v.end(), 0);
+  std::ofstream { path, std::ios::binary }
+    .write(reinterpret_cast<const char *>(v.data()), N*sizeof(int));
+  return path;
+}
+
+/// Read back the file content
+std::vector<int> read_file(const std::filesystem::path &path) {
+  std::vector<int> v(N);
+  std::ifstream { path, std::ios::binary }
+    .read(reinterpret_cast<char *>(v.data()), N*sizeof(int));
+  return v;
+}
+
+TEST_CASE("read-only file mapping", "[buffer]") {
+  auto path = make_file("trisycl_buffer_file_mapping_ro");
+  {
+    buffer<int> b { path };
+    REQUIRE(b.get_count() == N);
+    queue q;
+    q.submit([&] (handler &cgh) {
+        auto a = b.get_access<access::mode::read_write>(cgh);
+        cgh.parallel_for(range<1> { N }, [=] (id<1> i) { a[i] *= 2; });
+      });
+    auto a = b.get_access<access::mode::read>();
+    REQUIRE(a[N - 1] == 2*(N - 1));
+  }
+  // The copy-on-write left the file unchanged
+  REQUIRE(read_file(path)[N - 1] == N - 1);
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("writable file mapping", "[buffer]") {
+  auto path = make_file("trisycl_buffer_file_mapping_rw");
+  {
+    buffer<int> b { path, access::mode::read_write };
+    queue q;
+    q.submit([&] (handler &cgh) {
+        auto a = b.get_access<access::mode::read_write>(cgh);
+        cgh.parallel_for(range<1> { N }, [=] (id<1> i) { a[i] += 1; });
+      });
+  }
+  // The modifications are in the file after the buffer destruction
+  auto v = read_file(path);
+  REQUIRE(v[0] == 1);
+  REQUIRE(v[N - 1] == N);
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("2D file mapping at an offset", "[buffer]") {
+  auto path = make_file("trisycl_buffer_file_mapping_2d");
+  auto fd = ::open(path.c_str(), O_RDONLY);
+  REQUIRE(fd >= 0);
+  // Skip the first 10 integers, not aligned on a page
+  buffer<int, 2> b { file_descriptor { fd }, 10*sizeof(int),
+                     range<2> { 99, 100 } };
+  ::close(fd);
+  auto a = b.get_access<access::mode::read>();
+  REQUIRE(a[0][0] == 10);
+  REQUIRE(a[98][99] == 10 + 98*100 + 99);
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("missing file", "[buffer]") {
+  REQUIRE_THROWS_AS((buffer<int> {
+        std::filesystem::path { "/nonexistent/trisycl" },
+        range<1> { N } }),
+    invalid_parameter_error);
+}
+
+TEST_CASE("file too short", "[buffer]") {
+  auto path = make_file("trisycl_buffer_file_mapping_short");
+  REQUIRE_THROWS_AS((buffer<int> { path, range<1> { N }, sizeof(int) }),
+                    invalid_parameter_error);
+  auto fd = ::open(path.c_str(), O_RDONLY);
+  REQUIRE(fd >= 0);
+  REQUIRE_THROWS_AS((buffer<int> { file_descriptor { fd }, 0,
+                                   range<1> { N + 1 } }),
+                    invalid_parameter_error);
+  // An offset and a size wrapping around when added
+  REQUIRE_THROWS_AS((buffer<char> { file_descriptor { fd }, 16,
+                                    range<1> { ~std::size_t { 0 } - 8 } }),
+                    invalid_parameter_error);
+  ::close(fd);
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("file mapping with properties", "[buffer]") {
+  auto path = make_file("trisycl_buffer_file_mapping_properties");
+  {
+    buffer<int> b { path, access::mode::read,
+                    { property::buffer::alignment { 64 } } };
+    REQUIRE(b.has_property<property::buffer::alignment>());
+    // The copy-on-write storage follows the alignment property
+    auto a = b.get_access<access::mode::read_write>();
+    REQUIRE(reinterpret_cast<std::uintptr_t>(a.get_pointer()) % 64 == 0);
+    a[0] = 42;
+  }
+  REQUIRE(read_file(path)[0] == 0);
+  std::filesystem::remove(path);
+}
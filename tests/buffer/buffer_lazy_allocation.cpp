@@ -0,0 +1,62 @@
+/* RUN: %{execute}%s
+
+   Test that the host memory of a buffer is only allocated on its
+   first use
+*/
+
+#include <memory>
+#include <vector>
+
+/// Test explicitly a feature of triSYCL, so include the triSYCL header
+#include "triSYCL/sycl.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace trisycl;
+
+TEST_CASE("host memory allocated on first access", "[buffer]") {
+  auto b = std::make_shared<detail::buffer<int>>(range<1> { 1000 });
+  // Nothing is allocated yet but the geometry is known
+  REQUIRE(b->data() == nullptr);
+  REQUIRE(b->get_count() == 1000);
+  {
+    detail::accessor<int, 1, access::mode::discard_write,
+                     access::target::host_buffer> a { b };
+    REQUIRE(b->data() != nullptr);
+    REQUIRE(a.data() == b->data());
+    a[999] = 42;
+  }
+  detail::accessor<int, 1, access::mode::read,
+                   access::target::host_buffer> a { b };
+  REQUIRE(a[999] == 42);
+}
+
+TEST_CASE("lazily allocated buffer used by kernels", "[buffer]") {
+  int result = 0;
+  {
+    buffer<int> b { 1000 };
+    buffer<int> r { &result, 1 };
+    queue q;
+    q.submit([&] (handler &cgh) {
+        auto a = b.get_access<access::mode::discard_write>(cgh);
+        cgh.parallel_for(range<1> { 1000 }, [=] (id<1> i) { a[i] = i[0]; });
+      });
+    q.submit([&] (handler &cgh) {
+        auto a = b.get_access<access::mode::read>(cgh);
+        auto w = r.get_access<access::mode::write>(cgh);
+        cgh.single_task([=] { w[0] = a[999]; });
+      });
+  }
+  REQUIRE(result == 999);
+}
+
+TEST_CASE("never used buffer with a final write-back", "[buffer]") {
+  std::vector<int> v(10, 7);
+  {
+    buffer<int> b { 10 };
+    b.set_final_data(v.begin());
+    b.mark_as_written();
+  }
+  // The uninitialized content has been written back without crashing
+  REQUIRE(v.size() == 10);
+}
@@ -0,0 +1,97 @@
+/* RUN: %{execute}%s
+
+   Test that a read-only buffer is copied on write only where it is
+   accessed
+*/
+
+#include <cstddef>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+/// Test explicitly a feature of triSYCL, so include the triSYCL header
+#include "triSYCL/sycl.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace trisycl;
+
+/// Some read-only data where all the pages but the first can be hidden
+struct guarded_pages {
+  std::size_t page_size = ::sysconf(_SC_PAGESIZE);
+  std::size_t pages = 4;
+  std::size_t size = pages*page_size/sizeof(int);
+  int *data = static_cast<int *>(::mmap(nullptr, pages*page_size,
+                                        PROT_READ | PROT_WRITE,
+                                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+
+  guarded_pages() {
+    for (std::size_t i = 0; i != size; ++i)
+      data[i] = i;
+  }
+
+  /// Make a fault any access outside of the first page, or allow it
+  void protect_tail(bool hidden) {
+    ::mprotect(reinterpret_cast<char *>(data) + page_size,
+               (pages - 1)*page_size, hidden ? PROT_NONE : PROT_READ);
+  }
+
+  ~guarded_pages() { ::munmap(data, pages*page_size); }
+};
+
+TEST_CASE("only the written pages are copied", "[buffer]") {
+  guarded_pages g;
+  const int *source = g.data;
+  buffer<int> b { source, g.size };
+  queue q;
+  g.protect_tail(true);
+  q.submit([&] (handler &cgh) {
+      auto a = b.get_access<access::mode::read_write>(cgh, { 4 });
+      cgh.single_task([=] {
+          for (int i = 0; i != 4; ++i)
+            a[i] = -a[i];
+        });
+    });
+  q.submit([&] (handler &cgh) {
+      auto a = b.get_access<access::mode::read_write>(cgh, { 8 });
+      cgh.single_task([=] { a[7] += a[3]; });
+    });
+  q.wait();
+  // Now the whole buffer can be copied
+  g.protect_tail(false);
+  auto a = b.get_access<access::mode::read>();
+  for (std::size_t i = 0; i != g.size; ++i)
+    REQUIRE(a[i] == (i < 4 ? -int(i) : i == 7 ? 4 : int(i)));
+  // The read-only data are left untouched
+  REQUIRE(source[3] == 3);
+}
+
+TEST_CASE("discarded data are not copied", "[buffer]") {
+  guarded_pages g;
+  buffer<int> b { static_cast<const int *>(g.data), g.size };
+  g.protect_tail(true);
+  queue q;
+  q.submit([&] (handler &cgh) {
+      auto a = b.get_access<access::mode::discard_write>(cgh);
+      cgh.parallel_for(range<1> { g.size }, [=] (id<1> i) { a[i] = 1; });
+    });
+  auto a = b.get_access<access::mode::read>();
+  for (std::size_t i = 0; i != g.size; ++i)
+    REQUIRE(a[i] == 1);
+}
+
+TEST_CASE("sub-buffers copy only their pages", "[buffer]") {
+  guarded_pages g;
+  buffer<int> b { static_cast<const int *>(g.data), g.size };
+  g.protect_tail(true);
+  {
+    buffer<int> s { b, { 2 }, { 3 } };
+    auto a = s.get_access<access::mode::write>();
+    a[0] = 42;
+  }
+  g.protect_tail(false);
+  auto a = b.get_access<access::mode::read>();
+  REQUIRE(a[1] == 1);
+  REQUIRE(a[2] == 42);
+  REQUIRE(a[g.size - 1] == int(g.size - 1));
+}
@@ -0,0 +1,113 @@
+/* RUN: %{execute}%s
+
+   Test that a discarded buffer gets some fresh storage instead of
+   waiting for the previous readers
+*/
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+/// Test explicitly a feature of triSYCL, so include the triSYCL header
+#include "triSYCL/sycl.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace trisycl;
+
+// To have access to handy C++14 units, like in 1ms
+using namespace std::literals;
+
+TEST_CASE("a discarding writer overlaps with the previous reader",
+          "[buffer]") {
+  // The buffer storage is owned by the runtime
+  buffer<int> b { 1 };
+  int seen = 0;
+  std::atomic<bool> overlapped = false;
+  {
+    buffer<int> s { &seen, 1 };
+    queue q;
+
+    q.submit([&] (handler &cgh) {
+        auto a = b.get_access<access::mode::discard_write>(cgh);
+        cgh.single_task([=] { a[0] = 1; });
+      });
+    // A slow reader of version 1, waiting for the next version
+    q.submit([&] (handler &cgh) {
+        auto a = b.get_access<access::mode::read>(cgh);
+        auto r = s.get_access<access::mode::write>(cgh);
+        cgh.single_task([=, &overlapped] {
+            for (auto i = 0; i != 2000 && !overlapped; ++i)
+              std::this_thread::sleep_for(1ms);
+            r[0] = a[0];
+          });
+      });
+    // The next version is produced without waiting for the reader
+    q.submit([&] (handler &cgh) {
+        auto a = b.get_access<access::mode::discard_write>(cgh);
+        cgh.single_task([=] { a[0] = 2; });
+      });
+    q.submit([&] (handler &cgh) {
+        auto a = b.get_access<access::mode::read>(cgh);
+        cgh.single_task([=, &overlapped] {
+            if (a[0] == 2)
+              overlapped = true;
+          });
+      });
+    q.wait();
+  }
+  REQUIRE(overlapped);
+  // The slow reader still sees the version it was submitted with
+  REQUIRE(seen == 1);
+  REQUIRE(b.get_access<access::mode::read>()[0] == 2);
+}
+
+TEST_CASE("a buffer on host memory is not renamed", "[buffer]") {
+  int v = 0;
+  {
+    buffer<int> b { &v, 1 };
+    queue q;
+
+    q.submit([&] (handler &cgh) {
+        auto a = b.get_access<access::mode::read>(cgh);
+        cgh.single_task([=] { std::this_thread::sleep_for(20ms); });
+      });
+    q.submit([&] (handler &cgh) {
+        auto a = b.get_access<access::mode::discard_write>(cgh);
+        cgh.single_task([=] { a[0] = 3; });
+      });
+  }
+  REQUIRE(v == 3);
+}
+
+TEST_CASE("an in-order queue does not rename its buffers", "[buffer]") {
+  buffer<int> b { 1 };
+  std::atomic<bool> go = false;
+  int *first = nullptr;
+  int *second = nullptr;
+  {
+    queue q { property::queue::in_order {} };
+    q.submit([&] (handler &cgh) {
+        auto a = b.get_access<access::mode::discard_write>(cgh);
+        cgh.single_task([=, &go, &first] {
+            // Still running when the next command group is submitted
+            while (!go)
+              std::this_thread::yield();
+            first = a.get_pointer();
+            a[0] = 1;
+          });
+      });
+    // Already ordered after the previous kernel, so no renaming needed
+    q.submit([&] (handler &cgh) {
+        auto a = b.get_access<access::mode::discard_write>(cgh);
+        cgh.single_task([=, &second] {
+            second = a.get_pointer();
+            a[0] = 2;
+          });
+      });
+    go = true;
+    q.wait();
+  }
+  REQUIRE(first == second);
+  REQUIRE(b.get_access<access::mode::read>()[0] == 2);
+}
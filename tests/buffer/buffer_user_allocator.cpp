@@ -0,0 +1,85 @@
+/* RUN: %{execute}%s
+
+   Test that the buffer storage uses the allocator of the buffer
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/// Test explicitly a feature of triSYCL, so include the triSYCL header
+#include "triSYCL/sycl.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace trisycl;
+
+/// An allocator counting the allocated elements
+template <typename T>
+struct counting_allocator {
+  using value_type = T;
+
+  std::shared_ptr<std::size_t> allocated =
+    std::make_shared<std::size_t>(0);
+
+  counting_allocator() = default;
+
+  template <typename U>
+  counting_allocator(const counting_allocator<U> &other)
+    : allocated { other.allocated } {}
+
+  T *allocate(std::size_t n) {
+    *allocated += n;
+    return std::allocator<T> {}.allocate(n);
+  }
+
+  void deallocate(T *p, std::size_t n) {
+    *allocated -= n;
+    std::allocator<T> {}.deallocate(p, n);
+  }
+};
+
+TEST_CASE("user-provided allocator", "[buffer]") {
+  counting_allocator<int> a;
+  {
+    buffer<int, 1, counting_allocator<int>> b { range<1> { 100 }, a };
+    // The allocation is lazy
+    REQUIRE(*a.allocated == 0);
+    queue {}.submit([&] (handler &cgh) {
+        auto acc = b.get_access<access::mode::discard_write>(cgh);
+        cgh.parallel_for(range<1> { 100 }, [=] (id<1> i) { acc[i] = i[0]; });
+      });
+    REQUIRE(b.get_access<access::mode::read>()[99] == 99);
+    REQUIRE(*a.allocated == 100);
+  }
+  REQUIRE(*a.allocated == 0);
+  std::vector<int> v { 1, 2, 3 };
+  {
+    buffer<int, 1, counting_allocator<int>> b { v.begin(), v.end(), a };
+    REQUIRE(*a.allocated == 3);
+    REQUIRE(b.get_access<access::mode::read>()[2] == 3);
+  }
+  REQUIRE(*a.allocated == 0);
+}
+
+TEST_CASE("pooled allocator recycles the storage", "[buffer]") {
+  int *previous = nullptr;
+  for (int i = 0; i != 10; ++i) {
+    buffer<int, 1, pooled_buffer_allocator<int>> b { range<1> { 1000 } };
+    auto acc = b.get_access<access::mode::discard_write>();
+    acc[0] = i;
+    int *current = &acc[0];
+    // The storage is aligned on a cache line
+    REQUIRE(reinterpret_cast<std::uintptr_t>(current) % 64 == 0);
+    if (previous)
+      REQUIRE(current == previous);
+    previous = current;
+  }
+  // Close sizes share the same size class
+  REQUIRE(detail::size_class_pool::size_class(1000*sizeof(int))
+          == detail::size_class_pool::size_class(990*sizeof(int)));
+  REQUIRE(detail::size_class_pool::size_class(1) == 64);
+  REQUIRE(detail::size_class_pool::size_class(65) == 80);
+  REQUIRE(detail::size_class_pool::size_class(129) == 160);
+}
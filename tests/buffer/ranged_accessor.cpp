@@ -0,0 +1,103 @@
+/* RUN: %{execute}%s
+
+   Test the accessors to a region of a buffer
+*/
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+/// Test explicitly a feature of triSYCL, so include the triSYCL header
+#include "triSYCL/sycl.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace trisycl;
+
+// To have access to handy C++14 units, like in 1ms
+using namespace std::literals;
+
+constexpr size_t N = 4;
+constexpr size_t M = 6;
+
+TEST_CASE("ranged accessor describes its region", "[buffer]") {
+  buffer<int, 2> b { { N, M } };
+  queue q;
+  q.submit([&] (handler &cgh) {
+      auto a = b.get_access<access::mode::write>(cgh, { 2, 3 }, { 1, 2 });
+      REQUIRE(a.get_range() == range<2> { 2, 3 });
+      REQUIRE(a.get_offset() == id<2> { 1, 2 });
+      REQUIRE(a.get_count() == 6);
+      REQUIRE(a.get_size() == 6*sizeof(int));
+      auto whole = b.get_access<access::mode::read>(cgh);
+      REQUIRE(whole.get_range() == range<2> { N, M });
+      REQUIRE(whole.get_offset() == id<2> {});
+      cgh.single_task([] {});
+    });
+  REQUIRE_THROWS_AS((q.submit([&] (handler &cgh) {
+        b.get_access<access::mode::write>(cgh, { 2, 3 }, { 3, 0 });
+      })), invalid_object_error);
+}
+
+TEST_CASE("writers of disjoint tiles run concurrently", "[buffer]") {
+  int v[N][M] = {};
+  constexpr auto writers = 4;
+  std::atomic<int> running = 0;
+  {
+    buffer<int, 2> b { &v[0][0], { N, M } };
+    queue q;
+
+    // Split the buffer in 2x2 tiles of 2x3 elements
+    for (int t = 0; t != writers; ++t)
+      q.submit([&] (handler &cgh) {
+          id<2> offset { t/2*2, t%2*3 };
+          auto a = b.get_access<access::mode::write>(cgh, { 2, 3 }, offset);
+          cgh.single_task([=, &running] {
+              ++running;
+              // Wait for all the writers to be running at the same time
+              while (running != writers)
+                std::this_thread::sleep_for(1ms);
+              // The accessor is still indexed in the whole buffer
+              for (size_t i = 0; i != 2; ++i)
+                for (size_t j = 0; j != 3; ++j)
+                  a[offset[0] + i][offset[1] + j] = t;
+            });
+        });
+    // A reader of the whole buffer waits for all the tiles
+    q.submit([&] (handler &cgh) {
+        auto a = b.get_access<access::mode::read_write>(cgh);
+        cgh.single_task([=] { a[N - 1][M - 1] += 10; });
+      });
+  }
+  REQUIRE(running == writers);
+  for (size_t i = 0; i != N; ++i)
+    for (size_t j = 0; j != M; ++j)
+      REQUIRE(v[i][j] == static_cast<int>(i/2*2 + j/3
+                                          + (i == N - 1 && j == M - 1
+                                             ? 10 : 0)));
+}
+
+TEST_CASE("overlapping ranged accessors are ordered", "[buffer]") {
+  int v[N] = {};
+  {
+    buffer<int> b { v, N };
+    queue q;
+    q.submit([&] (handler &cgh) {
+        auto a = b.get_access<access::mode::write>(cgh, { 3 });
+        cgh.single_task([=] {
+            std::this_thread::sleep_for(50ms);
+            for (int i = 0; i != 3; ++i)
+              a[i] = 1;
+          });
+      });
+    // Overlaps the previous writer on element 2
+    q.submit([&] (handler &cgh) {
+        auto a = b.get_access<access::mode::read_write>(cgh, { 2 }, { 2 });
+        cgh.single_task([=] { a[2] += 1; a[3] += 5; });
+      });
+  }
+  REQUIRE(v[0] == 1);
+  REQUIRE(v[1] == 1);
+  REQUIRE(v[2] == 2);
+  REQUIRE(v[3] == 5);
+}
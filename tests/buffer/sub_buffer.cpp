@@ -0,0 +1,79 @@
+/* RUN: %{execute}%s
+
+   Test the sub-buffers and their dependencies
+*/
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+/// Test explicitly a feature of triSYCL, so include the triSYCL header
+#include "triSYCL/sycl.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace trisycl;
+
+// To have access to handy C++14 units, like in 1ms
+using namespace std::literals;
+
+TEST_CASE("writers of disjoint sub-buffers run concurrently", "[buffer]") {
+  constexpr std::size_t N = 1000;
+  std::vector<int> v(N);
+  std::atomic<int> running = 0;
+  {
+    buffer<int> b { v.data(), N };
+    buffer<int> halves[] { { b, id<1> { 0 }, range<1> { N/2 } },
+                           { b, id<1> { N/2 }, range<1> { N/2 } } };
+    REQUIRE(halves[1].is_sub_buffer());
+    REQUIRE(!b.is_sub_buffer());
+    queue q;
+    for (int h = 0; h != 2; ++h)
+      q.submit([&] (handler &cgh) {
+          auto a = halves[h].get_access<access::mode::discard_write>(cgh);
+          cgh.single_task([=, &running] {
+              ++running;
+              // Wait for both halves to be written at the same time
+              while (running != 2)
+                std::this_thread::sleep_for(1ms);
+              for (std::size_t i = 0; i != N/2; ++i)
+                a[i] = h*N/2 + i;
+            });
+        });
+    // A kernel on the whole buffer waits for both halves
+    q.submit([&] (handler &cgh) {
+        auto a = b.get_access<access::mode::read_write>(cgh);
+        cgh.parallel_for(range<1> { N }, [=] (id<1> i) { a[i] *= 2; });
+      });
+  }
+  for (int i = 0; i != N; ++i)
+    REQUIRE(v[i] == 2*i);
+}
+
+TEST_CASE("2D sub-buffer of rows", "[buffer]") {
+  buffer<int, 2> b { range<2> { 4, 8 } };
+  buffer<int, 2> rows { b, id<2> { 1, 0 }, range<2> { 2, 8 } };
+  queue q;
+  q.submit([&] (handler &cgh) {
+      auto a = b.get_access<access::mode::discard_write>(cgh);
+      cgh.parallel_for(b.get_range(), [=] (id<2> i) { a[i] = 0; });
+    });
+  q.submit([&] (handler &cgh) {
+      auto a = rows.get_access<access::mode::read_write>(cgh);
+      cgh.parallel_for(rows.get_range(), [=] (id<2> i) { a[i] = 1; });
+    });
+  auto a = b.get_access<access::mode::read>();
+  REQUIRE(a[0][7] == 0);
+  REQUIRE(a[1][0] == 1);
+  REQUIRE(a[2][7] == 1);
+  REQUIRE(a[3][0] == 0);
+}
+
+TEST_CASE("non contiguous sub-buffer", "[buffer]") {
+  buffer<int, 2> b { range<2> { 4, 8 } };
+  REQUIRE_THROWS_AS((buffer<int, 2> { b, id<2> { 0, 0 }, range<2> { 2, 4 } }),
+                    invalid_object_error);
+  REQUIRE_THROWS_AS((buffer<int, 2> { b, id<2> { 3, 0 }, range<2> { 2, 8 } }),
+                    invalid_object_error);
+}
@@ -0,0 +1,76 @@
+/* RUN: %{execute}%s
+
+   Test the lock-free waiting on tasks, buffers and queues
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/// Test explicitly a feature of triSYCL, so include the triSYCL header
+#include "triSYCL/sycl.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace trisycl;
+
+// To have access to handy C++14 units, like in 1ms
+using namespace std::literals;
+
+TEST_CASE("wait_until returns once the predicate holds", "[atomic_wait]") {
+  std::atomic<int> value = 0;
+  std::atomic<std::size_t> waiters = 0;
+  // Fast path when already satisfied, without registering as a waiter
+  detail::wait_until(value, waiters, [] (int v) { return v == 0; });
+  REQUIRE(waiters == 0);
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i != 4; ++i)
+    threads.emplace_back([&] {
+      detail::wait_until(value, waiters, [] (int v) { return v == 3; });
+    });
+  for (int i = 0; i != 3; ++i) {
+    std::this_thread::sleep_for(1ms);
+    ++value;
+    detail::notify_waiters(value, waiters);
+  }
+  for (auto &t : threads)
+    t.join();
+  REQUIRE(waiters == 0);
+}
+
+TEST_CASE("many host accessors and queue waits", "[atomic_wait]") {
+  constexpr int N = 1000;
+  queue q;
+  buffer<int> b { 1 };
+  b.get_access<access::mode::discard_write>()[0] = 0;
+  for (int i = 0; i != N; ++i) {
+    q.submit([&] (handler &cgh) {
+      auto a = b.get_access<access::mode::read_write>(cgh);
+      cgh.single_task([=] { ++a[0]; });
+    });
+    if (i % 100 == 0) {
+      // Wait on the buffer through a host accessor
+      auto a = b.get_access<access::mode::read>();
+      REQUIRE(a[0] == i + 1);
+    }
+  }
+  q.wait();
+  REQUIRE(b.get_access<access::mode::read>()[0] == N);
+}
+
+TEST_CASE("event waits from several threads", "[atomic_wait]") {
+  queue q;
+  auto e = q.submit([&] (handler &cgh) {
+    cgh.single_task([] { std::this_thread::sleep_for(10ms); });
+  });
+  std::vector<std::thread> threads;
+  for (int i = 0; i != 4; ++i)
+    threads.emplace_back([&] { e.wait(); });
+  for (auto &t : threads)
+    t.join();
+  REQUIRE(e.get_info<info::event::command_execution_status>()
+          == info::event_command_status::complete);
+}
@@ -0,0 +1,88 @@
+/* RUN: %{execute}%s
+
+   Test the runtime executor running the command groups
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+
+/// Test explicitly a feature of triSYCL, so include the triSYCL header
+#include "triSYCL/sycl.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace trisycl;
+
+// To have access to handy C++14 units, like in 1ms
+using namespace std::literals;
+
+// Number of command groups to submit
+constexpr auto N = 10000;
+
+TEST_CASE("many small kernels reuse the same workers", "[executor]") {
+  queue q;
+  std::atomic<int> count = 0;
+  std::mutex m;
+  std::set<std::thread::id> threads;
+
+  for (int i = 0; i != N; ++i)
+    q.submit([&] (handler &cgh) {
+        cgh.single_task([&] {
+            ++count;
+            std::lock_guard<std::mutex> lg { m };
+            threads.insert(std::this_thread::get_id());
+          });
+      });
+  q.wait();
+
+  REQUIRE(count == N);
+  // The kernels are run by the pool, not by a thread per command group
+  REQUIRE(threads.size() <= detail::executor::instance()->size());
+}
+
+TEST_CASE("kernels waiting for each other do not dead-lock", "[executor]") {
+  queue q;
+  // More spinning kernels than hardware threads
+  auto n = 2*std::thread::hardware_concurrency() + 1;
+  std::atomic<unsigned int> arrived = 0;
+
+  for (unsigned int i = 0; i != n; ++i)
+    q.submit([&] (handler &cgh) {
+        cgh.single_task([&] {
+            // Wait for all the kernels to be running concurrently
+            ++arrived;
+            while (arrived != n)
+              std::this_thread::sleep_for(1ms);
+          });
+      });
+  q.wait();
+
+  REQUIRE(arrived == n);
+}
+
+TEST_CASE("idle spare workers exit", "[executor]") {
+  auto e = detail::executor::instance();
+  auto core = std::max(1U, std::thread::hardware_concurrency());
+  queue q;
+  // Block all the workers long enough to get some spare workers
+  auto n = core + 2;
+  std::atomic<unsigned int> arrived = 0;
+  for (unsigned int i = 0; i != n; ++i)
+    q.submit([&] (handler &cgh) {
+        cgh.single_task([&] {
+            ++arrived;
+            while (arrived != n)
+              std::this_thread::sleep_for(1ms);
+          });
+      });
+  // Some spare workers were needed to run them all concurrently
+  q.wait();
+  // The spare workers exit after being idle for a while
+  for (auto i = 0; i != 1000 && e->size() != core; ++i)
+    std::this_thread::sleep_for(10ms);
+  REQUIRE(e->size() == core);
+}
@@ -0,0 +1,90 @@
+/* RUN: %{execute}%s
+
+   Test the bulk copies split across the runtime executor
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+/// Test explicitly a feature of triSYCL, so include the triSYCL header
+#include "triSYCL/sycl.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace trisycl;
+
+// Large enough to be copied in parallel, with a partial last block
+constexpr std::size_t N = 3*detail::parallel_copy_threshold/sizeof(int) + 7;
+
+/// A type which is not trivially copyable but can be copied in parallel
+struct counted {
+  int v = 0;
+  counted() = default;
+  counted(int v) : v { v } {}
+  counted(const counted &other) noexcept : v { other.v + 1 } {}
+  counted &operator=(const counted &other) noexcept {
+    v = other.v + 1;
+    return *this;
+  }
+};
+
+/* A large buffer with a static storage duration, written back to a
+   vector on destruction at the program exit with a parallel copy */
+std::vector<int> final_data(N);
+buffer<int> global_buffer { range<1> { N } };
+
+TEST_CASE("a static buffer is written back at exit", "[parallel_copy]") {
+  global_buffer.set_final_data(final_data.begin());
+  auto a = global_buffer.get_access<access::mode::discard_write>();
+  std::iota(a.begin(), a.end(), 0);
+}
+
+TEST_CASE("parallel_copy_n copies all the elements", "[parallel_copy]") {
+  std::vector<int> in(N);
+  std::iota(in.begin(), in.end(), 0);
+  std::vector<int> out(N);
+  detail::parallel_copy_n(in.begin(), N, out.begin());
+  REQUIRE(in == out);
+
+  // Not random-access, so sequential
+  std::list<int> l { 1, 2, 3 };
+  std::vector<int> small(3);
+  detail::parallel_copy_n(l.begin(), 3, small.begin());
+  REQUIRE(small == std::vector<int> { 1, 2, 3 });
+
+  std::vector<counted> cin(N/4, counted { 1 });
+  std::vector<counted> cout(N/4);
+  detail::parallel_copy_n(cin.begin(), cin.size(), cout.begin());
+  REQUIRE(std::all_of(cout.begin(), cout.end(),
+                      [] (auto &c) { return c.v == 3; }));
+}
+
+TEST_CASE("parallel_uninitialized_copy_n constructs all the elements",
+          "[parallel_copy]") {
+  std::vector<int> in(N);
+  std::iota(in.begin(), in.end(), 0);
+  auto out = std::make_unique_for_overwrite<int[]>(N);
+  detail::parallel_uninitialized_copy_n(in.data(), N, out.get());
+  REQUIRE(std::equal(in.begin(), in.end(), out.get()));
+}
+
+TEST_CASE("large buffer initialization and write-back", "[parallel_copy]") {
+  std::vector<int> in(N);
+  std::iota(in.begin(), in.end(), 0);
+  std::vector<int> out(N);
+  {
+    buffer<int> b { in.begin(), in.end() };
+    b.set_final_data(out.begin());
+    queue {}.submit([&] (handler &cgh) {
+        auto a = b.get_access<access::mode::read_write>(cgh);
+        cgh.parallel_for(range<1> { N }, [=] (id<1> i) { a[i] *= 2; });
+      });
+  }
+  for (auto &e : in)
+    e *= 2;
+  REQUIRE(in == out);
+}
@@ -0,0 +1,93 @@
+/* RUN: %{execute}%s
+
+   Test the small containers and the recycling allocator used to
+   submit command groups without heap allocation
+*/
+
+#include <array>
+#include <memory>
+#include <string>
+
+/// Test explicitly a feature of triSYCL, so include the triSYCL header
+#include "triSYCL/sycl.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace trisycl;
+
+TEST_CASE("small_vector spills to the heap", "[small_containers]") {
+  detail::small_vector<std::shared_ptr<int>, 2> v;
+  auto p = std::make_shared<int>(42);
+  v.push_back(p);
+  v.push_back(p);
+  REQUIRE(v.capacity() == 2);
+  v.push_back(p);
+  v.emplace_back(v[0]);
+  REQUIRE(v.size() == 4);
+  REQUIRE(v.capacity() > 2);
+  REQUIRE(p.use_count() == 5);
+  auto w = std::move(v);
+  REQUIRE(v.empty());
+  REQUIRE(w.size() == 4);
+  decltype(w) inline_one;
+  inline_one.push_back(p);
+  inline_one.swap(w);
+  REQUIRE(inline_one.size() == 4);
+  REQUIRE(w.size() == 1);
+  REQUIRE(*w.back() == 42);
+  w.clear();
+  inline_one.clear();
+  REQUIRE(p.use_count() == 1);
+}
+
+TEST_CASE("small_function stores small and large closures",
+          "[small_containers]") {
+  auto counter = std::make_shared<int>(0);
+  detail::small_function<void(void)> f;
+  REQUIRE(!f);
+  REQUIRE_THROWS(f());
+  // A move-only closure
+  f = [c = counter, u = std::make_unique<int>(1)] () mutable { *c += *u; };
+  f();
+  auto g = std::move(f);
+  REQUIRE(!f);
+  g();
+  REQUIRE(*counter == 2);
+  // Too large to be inline
+  std::string padding(200, 'a');
+  detail::small_function<std::size_t(int)> h {
+    [padding, big = std::array<char, 256> {}] (int i) {
+      return padding.size() + big.size() + i;
+    } };
+  auto h2 = std::move(h);
+  REQUIRE(h2(1) == 457);
+  g = nullptr;
+  REQUIRE(counter.use_count() == 1);
+}
+
+TEST_CASE("recycling_allocator reuses the freed memory",
+          "[small_containers]") {
+  auto pool = std::make_shared<detail::recycling_pool>();
+  detail::recycling_allocator<std::byte> a { pool };
+  auto p = std::allocate_shared<std::string>(a, "some string");
+  auto address = p.get();
+  p.reset();
+  auto q = std::allocate_shared<std::string>(a, "another one");
+  REQUIRE(q.get() == address);
+  // The pool is kept alive by the objects allocated from it
+  pool.reset();
+  q.reset();
+}
+
+TEST_CASE("command groups run with recycled tasks", "[small_containers]") {
+  constexpr int N = 1000;
+  queue q;
+  buffer<int> b { 1 };
+  b.get_access<access::mode::discard_write>()[0] = 0;
+  for (int i = 0; i != N; ++i)
+    q.submit([&] (handler &cgh) {
+      auto a = b.get_access<access::mode::read_write>(cgh);
+      cgh.single_task([=] { ++a[0]; });
+    });
+  REQUIRE(b.get_access<access::mode::read>()[0] == N);
+}
@@ -0,0 +1,56 @@
+/* RUN: %{execute}%s
+
+   Test the export of the execution trace
+*/
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+/// Test explicitly a feature of triSYCL, so include the triSYCL header
+#include "triSYCL/sycl.hpp"
+#include "triSYCL/vendor/triSYCL/trace.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace trisycl;
+
+// To have access to handy C++14 units, like in 1ms
+using namespace std::literals;
+
+class producer;
+class consumer;
+
+TEST_CASE("trace of dependent kernels", "[trace]") {
+  namespace trace = ::trisycl::vendor::trisycl::trace;
+  trace::start();
+  {
+    queue q;
+    buffer<int> b { 1 };
+    q.submit([&] (handler &cgh) {
+      auto a = b.get_access<access::mode::discard_write>(cgh);
+      cgh.single_task<producer>([=] {
+        // Still running when the consumer is submitted
+        std::this_thread::sleep_for(10ms);
+        a[0] = 1;
+      });
+    });
+    q.submit([&] (handler &cgh) {
+      auto a = b.get_access<access::mode::read_write>(cgh);
+      cgh.single_task<consumer>([=] { a[0] += 1; });
+    });
+    q.wait();
+  }
+  trace::stop();
+  std::ostringstream o;
+  trace::write_chrome_trace(o);
+  auto json = o.str();
+  REQUIRE(json.starts_with("{\"displayTimeUnit\""));
+  REQUIRE(json.find("\"name\":\"producer\"") != std::string::npos);
+  REQUIRE(json.find("\"name\":\"consumer\"") != std::string::npos);
+  REQUIRE(json.find("executor worker") != std::string::npos);
+  // The flow of the buffer dependency between the 2 kernels
+  REQUIRE(json.find("\"ph\":\"s\"") != std::string::npos);
+  REQUIRE(json.find("\"ph\":\"f\"") != std::string::npos);
+  REQUIRE(json.find(" write\"") != std::string::npos);
+}
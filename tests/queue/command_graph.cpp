@@ -0,0 +1,134 @@
+/* RUN: %{execute}%s
+
+   Test the recording and replay of command groups
+*/
+
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <thread>
+
+/// Test explicitly a feature of triSYCL, so include the triSYCL header
+#include "triSYCL/sycl.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace trisycl;
+
+// To have access to handy C++14 units, like in 1ms
+using namespace std::literals;
+
+// Number of replays
+constexpr auto N = 100;
+
+TEST_CASE("a recorded sequence is replayed in order", "[command_graph]") {
+  int x = 0;
+  int y[4] = {};
+  std::atomic<int> executed = 0;
+  {
+    buffer<int> bx { &x, 1 };
+    buffer<int> by { y, 4 };
+    queue q;
+
+    q.begin_recording();
+    REQUIRE_THROWS_AS(q.begin_recording(), invalid_object_error);
+    q.submit([&] (handler &cgh) {
+        auto a = bx.get_access<access::mode::read_write>(cgh);
+        cgh.single_task([=, &executed] {
+            ++executed;
+            ++a[0];
+          });
+      });
+    q.submit([&] (handler &cgh) {
+        auto a = bx.get_access<access::mode::read>(cgh);
+        auto b = by.get_access<access::mode::read_write>(cgh);
+        cgh.parallel_for(range<1> { 4 },
+                         [=] (id<1> i) { b[i] += a[0] * (i[0] + 1); });
+      });
+    // A command group without kernel is not recorded
+    q.submit([&] (handler &) {});
+    auto g = q.end_recording();
+    REQUIRE_THROWS_AS(q.end_recording(), invalid_object_error);
+    REQUIRE(g.size() == 2);
+    // Nothing has been executed yet
+    q.wait();
+    REQUIRE(executed == 0);
+
+    for (int i = 0; i != N; ++i)
+      g.replay();
+    // The replays interleave with normal submissions
+    q.submit([&] (handler &cgh) {
+        auto a = bx.get_access<access::mode::read_write>(cgh);
+        cgh.single_task([=] { a[0] *= 2; });
+      });
+    g.replay().wait();
+    REQUIRE(executed == N + 1);
+  }
+  // x = 2*N + 1 and y[i] = (i + 1)*(1 + 2 + ... + N + 2*N + 1)
+  REQUIRE(x == 2*N + 1);
+  for (int i = 0; i != 4; ++i)
+    REQUIRE(y[i] == (i + 1)*(N*(N + 1)/2 + 2*N + 1));
+}
+
+
+TEST_CASE("a graph outliving its buffers is no longer replayable",
+          "[command_graph]") {
+  int x = 0;
+  queue q;
+  std::optional<command_graph> g;
+  {
+    buffer<int> bx { &x, 1 };
+    q.begin_recording();
+    REQUIRE_THROWS_AS(q.submit([&] (handler &cgh) {
+          cgh.depends_on(event {});
+        }), invalid_object_error);
+    q.submit([&] (handler &cgh) {
+        auto a = bx.get_access<access::mode::read_write>(cgh);
+        cgh.single_task([=] { ++a[0]; });
+      });
+    g = q.end_recording();
+    g->replay();
+    g->replay();
+    // The buffer destruction does not wait for the graph
+  }
+  REQUIRE(x == 2);
+  REQUIRE_THROWS_AS(g->replay(), invalid_object_error);
+}
+
+
+TEST_CASE("a buffer can be renamed again once its graphs are destroyed",
+          "[command_graph]") {
+  buffer<int> b { 1 };
+  queue q;
+  {
+    q.begin_recording();
+    q.submit([&] (handler &cgh) {
+        auto a = b.get_access<access::mode::discard_write>(cgh);
+        cgh.single_task([=] { a[0] = 1; });
+      });
+    auto g = q.end_recording();
+    g.replay().wait();
+  }
+  int *read = nullptr;
+  int *written = nullptr;
+  std::atomic<bool> overlapped = false;
+  q.submit([&] (handler &cgh) {
+      auto a = b.get_access<access::mode::read>(cgh);
+      cgh.single_task([=, &read, &overlapped] {
+          // Bounded, so that a missing renaming fails instead of hanging
+          for (auto i = 0; i != 2000 && !overlapped; ++i)
+            std::this_thread::sleep_for(1ms);
+          read = a.get_pointer();
+        });
+    });
+  q.submit([&] (handler &cgh) {
+      auto a = b.get_access<access::mode::discard_write>(cgh);
+      cgh.single_task([=, &written, &overlapped] {
+          written = a.get_pointer();
+          overlapped = true;
+        });
+    });
+  q.wait();
+  // The writer got some fresh storage instead of waiting for the reader
+  REQUIRE(read != written);
+}
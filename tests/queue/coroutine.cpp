@@ -0,0 +1,82 @@
+/* RUN: %{execute}%s
+
+   Test the co_await on events and buffers from coroutines
+*/
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <thread>
+#include <vector>
+
+/// Test explicitly a feature of triSYCL, so include the triSYCL header
+#include "triSYCL/sycl.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace trisycl;
+
+// To have access to handy C++14 units, like in 1ms
+using namespace std::literals;
+
+/// A minimal coroutine type running eagerly up to completion
+struct detached {
+  struct promise_type {
+    detached get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+constexpr int N = 64;
+
+/// A pipeline of kernels driven by a coroutine
+detached pipeline(queue &q, buffer<int> &b, int value,
+                  std::atomic<int> &done, std::atomic<bool> &ok) {
+  co_await q.submit([&] (handler &cgh) {
+    auto a = b.get_access<access::mode::discard_write>(cgh);
+    cgh.parallel_for(range<1> { N }, [=] (id<1> i) { a[i] = value; });
+  });
+  co_await q.submit([&] (handler &cgh) {
+    auto a = b.get_access<access::mode::read_write>(cgh);
+    cgh.parallel_for(range<1> { N }, [=] (id<1> i) { a[i] += i[0]; });
+  });
+  // The buffer is no longer used, so the host accessor does not block
+  co_await b;
+  auto a = b.get_access<access::mode::read>();
+  for (int i = 0; i != N; ++i)
+    if (a[i] != value + i)
+      ok = false;
+  ++done;
+}
+
+TEST_CASE("many coroutines awaiting kernels", "[coroutine]") {
+  constexpr int pipelines = 200;
+  queue q;
+  std::vector<buffer<int>> buffers;
+  for (int p = 0; p != pipelines; ++p)
+    buffers.emplace_back(range<1> { N });
+  std::atomic<int> done = 0;
+  std::atomic<bool> ok = true;
+  for (int p = 0; p != pipelines; ++p)
+    pipeline(q, buffers[p], p, done, ok);
+  while (done != pipelines)
+    std::this_thread::sleep_for(1ms);
+  REQUIRE(ok);
+}
+
+TEST_CASE("co_await a completed event", "[coroutine]") {
+  queue q;
+  auto e = q.submit([&] (handler &cgh) { cgh.single_task([] {}); });
+  e.wait();
+  bool resumed = false;
+  [&] () -> detached {
+    co_await e;
+    // Not suspended, so still on this thread
+    resumed = true;
+  }();
+  REQUIRE(resumed);
+}
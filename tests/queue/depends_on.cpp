@@ -0,0 +1,85 @@
+/* RUN: %{execute}%s
+
+   Test explicit dependencies between command groups from events
+*/
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include <sycl/sycl.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace sycl;
+
+// To have access to handy C++14 units, like in 1ms
+using namespace std::literals;
+
+TEST_CASE("a kernel waits for the events it depends on", "[handler]") {
+  queue q;
+  std::atomic<bool> go = false;
+  std::atomic<int> done = 0;
+  std::atomic<bool> ordered = false;
+
+  std::vector<event> producers;
+  for (int i = 0; i != 2; ++i)
+    producers.push_back(q.submit([&] (handler &cgh) {
+          cgh.single_task([&] {
+              while (!go)
+                std::this_thread::sleep_for(1ms);
+              std::this_thread::sleep_for(10ms);
+              ++done;
+            });
+        }));
+  // No buffer relates the kernels, only the events
+  auto e = q.submit([&] (handler &cgh) {
+      cgh.depends_on(producers);
+      cgh.single_task([&] { ordered = done == 2; });
+    });
+  auto f = q.submit([&] (handler &cgh) {
+      cgh.depends_on(e);
+      cgh.single_task([&] { ++done; });
+    });
+  // The host was not blocked by the submissions
+  REQUIRE(done == 0);
+  go = true;
+  f.wait();
+  REQUIRE(ordered);
+  REQUIRE(done == 3);
+}
+
+TEST_CASE("depending on a complete event does not block", "[handler]") {
+  queue q;
+  auto e = q.submit([&] (handler &cgh) { cgh.single_task([] {}); });
+  e.wait();
+  std::atomic<bool> executed = false;
+  q.submit([&] (handler &cgh) {
+      cgh.depends_on(e);
+      cgh.depends_on(event {});
+      cgh.single_task([&] { executed = true; });
+    });
+  q.wait();
+  REQUIRE(executed);
+}
+
+TEST_CASE("a kernel waits for a pending event without task",
+          "[handler]") {
+  queue q;
+  std::promise<void> p;
+  // Some work tracked outside of the task graph
+  event pending { std::make_shared<detail::future_event>(
+      p.get_future().share()) };
+  std::atomic<bool> ready = false;
+  std::atomic<bool> ordered = false;
+  auto e = q.submit([&] (handler &cgh) {
+      cgh.depends_on(pending);
+      cgh.single_task([&] { ordered = ready.load(); });
+    });
+  ready = true;
+  p.set_value();
+  e.wait();
+  REQUIRE(ordered);
+}
@@ -0,0 +1,63 @@
+/* RUN: %{execute}%s
+
+   Test the host_task command integrated in the task graph
+*/
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+/// Test explicitly a feature of triSYCL, so include the triSYCL header
+#include "triSYCL/sycl.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace trisycl;
+
+// To have access to handy C++14 units, like in 1ms
+using namespace std::literals;
+
+constexpr int N = 1000;
+
+TEST_CASE("host_task between kernels", "[host_task]") {
+  queue q;
+  buffer<int> a { N };
+  buffer<int> b { N };
+  q.submit([&] (handler &cgh) {
+    auto acc = a.get_access<access::mode::discard_write>(cgh);
+    cgh.parallel_for(range<1> { N }, [=] (id<1> i) { acc[i] = i[0]; });
+  });
+  std::atomic<bool> submitted = false;
+  auto e = q.submit([&] (handler &cgh) {
+    auto in = a.get_access<access::mode::read, access::target::host_task>(cgh);
+    auto out =
+      b.get_access<access::mode::discard_write, access::target::host_task>(cgh);
+    cgh.host_task([=, &submitted] {
+      // Would dead-lock if the submitting thread was blocked
+      while (!submitted)
+        std::this_thread::sleep_for(1ms);
+      for (int i = 0; i != N; ++i)
+        out[i] = 2*in[i];
+    });
+  });
+  submitted = true;
+  q.submit([&] (handler &cgh) {
+    auto acc = b.get_access<access::mode::read_write>(cgh);
+    cgh.parallel_for(range<1> { N }, [=] (id<1> i) { acc[i] += 1; });
+  });
+  e.wait();
+  REQUIRE(e.get_info<info::event::command_execution_status>()
+          == info::event_command_status::complete);
+  auto acc = b.get_access<access::mode::read>();
+  for (int i = 0; i != N; ++i)
+    REQUIRE(acc[i] == 2*i + 1);
+}
+
+TEST_CASE("host_task runs on a worker", "[host_task]") {
+  queue q;
+  std::thread::id worker;
+  q.submit([&] (handler &cgh) {
+    cgh.host_task([&] { worker = std::this_thread::get_id(); });
+  }).wait();
+  REQUIRE(worker != std::this_thread::get_id());
+}
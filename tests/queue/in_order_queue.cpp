@@ -0,0 +1,73 @@
+/* RUN: %{execute}%s
+
+   Test the queues executing their command groups in submission order
+*/
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <sycl/sycl.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace sycl;
+
+// To have access to handy C++14 units, like in 1ms
+using namespace std::literals;
+
+// Number of command groups to submit
+constexpr auto N = 1000;
+
+TEST_CASE("kernels without buffers run in submission order", "[queue]") {
+  queue q { property::queue::in_order {} };
+  REQUIRE(q.has_property<property::queue::in_order>());
+  REQUIRE(!q.has_property<property::queue::enable_profiling>());
+  std::atomic<int> count = 0;
+  std::atomic<bool> ordered = true;
+
+  for (int i = 0; i != N; ++i)
+    q.submit([&, i] (handler &cgh) {
+        cgh.single_task([&, i] {
+            if (i == 0)
+              // Give some time to the next ones to overtake
+              std::this_thread::sleep_for(10ms);
+            if (count++ != i)
+              ordered = false;
+          });
+      });
+  q.wait();
+  REQUIRE(count == N);
+  REQUIRE(ordered);
+}
+
+TEST_CASE("an in-order queue still waits for the other queues",
+          "[queue]") {
+  int v = 0;
+  {
+    buffer<int> b { &v, 1 };
+    queue q;
+    queue in_order_q { property_list { property::queue::in_order {},
+                                       property::queue::enable_profiling {} } };
+    REQUIRE(in_order_q.has_property<property::queue::enable_profiling>());
+
+    q.submit([&] (handler &cgh) {
+        auto a = b.get_access<access::mode::write>(cgh);
+        cgh.single_task([=] {
+            std::this_thread::sleep_for(20ms);
+            a[0] = 2;
+          });
+      });
+    for (int i = 0; i != 3; ++i)
+      in_order_q.submit([&] (handler &cgh) {
+          auto a = b.get_access<access::mode::read_write>(cgh);
+          cgh.single_task([=] { a[0] *= 3; });
+        });
+    // And the other way around
+    q.submit([&] (handler &cgh) {
+        auto a = b.get_access<access::mode::read_write>(cgh);
+        cgh.single_task([=] { a[0] += 1; });
+      });
+  }
+  REQUIRE(v == 55);
+}
@@ -0,0 +1,106 @@
+/* RUN: %{execute}%s
+
+   Test the fusion of elementwise kernels
+*/
+
+#include <numeric>
+#include <vector>
+
+/// Test explicitly a feature of triSYCL, so include the triSYCL header
+#include "triSYCL/sycl.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace trisycl;
+
+// Not a multiple of the fusion chunk size
+constexpr std::size_t N = 100'003;
+
+TEST_CASE("a chain of elementwise kernels is fused", "[fusion]") {
+  std::vector<int> in(N);
+  std::iota(in.begin(), in.end(), 0);
+  std::vector<int> out(N);
+  {
+    buffer<int> a { in.data(), N };
+    buffer<int> b { N };
+    buffer<int> c { out.data(), N };
+    queue q;
+
+    q.start_fusion();
+    q.submit([&] (handler &cgh) {
+        auto ka = a.get_access<access::mode::read>(cgh);
+        auto kb = b.get_access<access::mode::discard_write>(cgh);
+        cgh.parallel_for(range<1> { N }, [=] (id<1> i) { kb[i] = 2*ka[i]; });
+      });
+    q.submit([&] (handler &cgh) {
+        auto kb = b.get_access<access::mode::read_write>(cgh);
+        cgh.parallel_for(range<1> { N }, [=] (item<1> i) { kb[i] += 1; });
+      });
+    q.submit([&] (handler &cgh) {
+        auto kb = b.get_access<access::mode::read>(cgh);
+        auto kc = c.get_access<access::mode::discard_write>(cgh);
+        cgh.parallel_for(range<1> { N }, [=] (id<1> i) { kc[i] = kb[i]*kb[i]; });
+      });
+    q.complete_fusion().wait();
+  }
+  for (std::size_t i = 0; i != N; ++i)
+    REQUIRE(out[i] == static_cast<int>((2*i + 1)*(2*i + 1)));
+}
+
+TEST_CASE("only kernels on the same iteration space are fused",
+          "[fusion]") {
+  int m[3][5];
+  {
+    buffer<int, 2> b { &m[0][0], { 3, 5 } };
+    queue q;
+
+    q.begin_recording(true);
+    q.submit([&] (handler &cgh) {
+        auto k = b.get_access<access::mode::discard_write>(cgh);
+        cgh.parallel_for(range<2> { 3, 5 },
+                         [=] (id<2> i) { k[i] = i[0]*10 + i[1]; });
+      });
+    q.submit([&] (handler &cgh) {
+        auto k = b.get_access<access::mode::read_write>(cgh);
+        cgh.parallel_for(range<2> { 3, 5 }, [=] (id<2> i) { k[i] *= 2; });
+      });
+    // A different iteration space
+    q.submit([&] (handler &cgh) {
+        auto k = b.get_access<access::mode::read_write>(cgh);
+        cgh.parallel_for(range<2> { 1, 5 }, [=] (id<2> i) { k[i] += 1; });
+      });
+    // A single task
+    q.submit([&] (handler &cgh) {
+        auto k = b.get_access<access::mode::read_write>(cgh);
+        cgh.single_task([=] { k[2][4] = -1; });
+      });
+    auto g = q.end_recording();
+    REQUIRE(g.size() == 4);
+    g.fuse();
+    REQUIRE(g.size() == 3);
+    g.replay().wait();
+  }
+  for (int i = 0; i != 3; ++i)
+    for (int j = 0; j != 5; ++j)
+      REQUIRE(m[i][j] == (i == 2 && j == 4 ? -1 : (i*10 + j)*2 + (i == 0)));
+}
+
+TEST_CASE("kernels recorded without fusion are not fused", "[fusion]") {
+  int v[8];
+  {
+    buffer<int> b { v, 8 };
+    queue q;
+    q.begin_recording();
+    for (int k = 0; k != 2; ++k)
+      q.submit([&] (handler &cgh) {
+          auto a = b.get_access<access::mode::read_write>(cgh);
+          cgh.parallel_for(range<1> { 8 }, [=] (id<1> i) { a[i] = i[0] + k; });
+        });
+    auto g = q.end_recording();
+    g.fuse();
+    REQUIRE(g.size() == 2);
+    g.replay().wait();
+  }
+  for (int i = 0; i != 8; ++i)
+    REQUIRE(v[i] == i + 1);
+}
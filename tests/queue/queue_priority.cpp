@@ -0,0 +1,122 @@
+/* RUN: %{execute}%s
+
+   Test the queue priorities and the yielding range kernels
+*/
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/// Test explicitly a feature of triSYCL, so include the triSYCL header
+#include "triSYCL/sycl.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace trisycl;
+
+// To have access to handy C++14 units, like in 1ms
+using namespace std::literals;
+
+TEST_CASE("high priority work is started first", "[queue_priority]") {
+  auto e = detail::executor::instance();
+  std::atomic<bool> gate = false;
+  std::atomic<std::size_t> blocked = 0;
+  std::atomic<std::size_t> done = 0;
+  std::size_t blockers = 0;
+  // Keep all the workers busy
+  while (blocked != e->size()) {
+    if (blockers < e->size()) {
+      ++blockers;
+      e->submit([&] {
+        ++blocked;
+        while (!gate)
+          std::this_thread::sleep_for(1ms);
+        ++done;
+      });
+    }
+    std::this_thread::sleep_for(1ms);
+  }
+  constexpr std::size_t low_works = 100;
+  constexpr std::size_t high_works = 4;
+  std::atomic<std::size_t> order = 0;
+  std::vector<std::size_t> high_order(high_works);
+  for (std::size_t i = 0; i != low_works; ++i)
+    e->submit([&] { ++order; ++done; }, 0);
+  for (std::size_t i = 0; i != high_works; ++i)
+    e->submit([&, i] { high_order[i] = order++; ++done; }, 2);
+  gate = true;
+  while (done != blockers + low_works + high_works)
+    std::this_thread::sleep_for(1ms);
+  for (auto o : high_order)
+    // Only some low priority work started concurrently might be first
+    REQUIRE(o < high_works + e->size());
+}
+
+TEST_CASE("queue priority property", "[queue_priority]") {
+  queue q { property::queue::priority { property::queue::priority::high } };
+  REQUIRE(q.has_property<property::queue::priority>());
+  REQUIRE(q.get_property<property::queue::priority>().get_level()
+          == property::queue::priority::high);
+  buffer<int> b { 1 };
+  q.submit([&] (handler &cgh) {
+    auto a = b.get_access<access::mode::discard_write>(cgh);
+    cgh.single_task([=] { a[0] = 42; });
+  });
+  REQUIRE(b.get_access<access::mode::read>()[0] == 42);
+}
+
+TEST_CASE("yielding range kernel", "[queue_priority]") {
+  constexpr std::size_t N = 300000;
+  queue batch { property::queue::priority { property::queue::priority::low,
+                                            true } };
+  queue urgent { property::queue::priority {
+      property::queue::priority::high } };
+  buffer<int> a { N };
+  buffer<int> b { 1 };
+  batch.submit([&] (handler &cgh) {
+    auto acc = a.get_access<access::mode::discard_write>(cgh);
+    cgh.parallel_for(range<1> { N }, [=] (id<1> i) {
+      acc[i] = static_cast<int>(i[0]);
+    });
+  });
+  urgent.submit([&] (handler &cgh) {
+    auto acc = b.get_access<access::mode::discard_write>(cgh);
+    cgh.single_task([=] { acc[0] = 3; });
+  });
+  batch.wait();
+  urgent.wait();
+  auto acc = a.get_access<access::mode::read>();
+  for (std::size_t i = 0; i != N; ++i)
+    REQUIRE(acc[i] == static_cast<int>(i));
+  REQUIRE(b.get_access<access::mode::read>()[0] == 3);
+}
+
+TEST_CASE("yielding range kernel resumed after urgent work",
+          "[queue_priority]") {
+  constexpr std::size_t N = 4*handler::yield_chunk_size;
+  auto e = detail::executor::instance();
+  std::atomic<bool> urgent_started = false;
+  std::vector<int> v(N);
+  {
+    queue batch { property::queue::priority {
+        property::queue::priority::low, true } };
+    buffer<int> a { v.data(), N };
+    batch.submit([&] (handler &cgh) {
+      auto acc = a.get_access<access::mode::discard_write>(cgh);
+      cgh.parallel_for(range<1> { N }, [=, &urgent_started] (id<1> i) {
+        if (i[0] == 0)
+          // Some urgent work becomes ready while the kernel runs
+          e->submit([&urgent_started] { urgent_started = true; }, 2);
+        if (i[0] == N - 1)
+          /* The urgent work is started before the rest of the kernel,
+             which does not run it on its own stack */
+          while (!urgent_started)
+            std::this_thread::yield();
+        acc[i] = static_cast<int>(i[0]);
+      });
+    });
+  }
+  for (std::size_t i = 0; i != N; ++i)
+    REQUIRE(v[i] == static_cast<int>(i));
+}
@@ -0,0 +1,56 @@
+/* RUN: %{execute}%s
+
+   Test the sender/receiver adapter of the queue
+*/
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+/// Test explicitly a feature of triSYCL, so include the triSYCL header
+#include "triSYCL/sycl.hpp"
+#include "triSYCL/vendor/triSYCL/execution.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace trisycl;
+namespace ex = ::trisycl::vendor::trisycl::execution;
+
+TEST_CASE("schedule completes on a worker", "[sender]") {
+  queue q;
+  auto caller = std::this_thread::get_id();
+  auto [on_worker] = ex::sync_wait(ex::schedule(q) | ex::then([&] {
+      return std::this_thread::get_id() != caller;
+    })).value();
+  REQUIRE(on_worker);
+}
+
+TEST_CASE("bulk maps onto parallel_for", "[sender]") {
+  constexpr int N = 1000;
+  ex::queue_scheduler s { queue {} };
+  std::vector<int> v(N);
+  auto [sum] = ex::sync_wait(ex::schedule(s)
+                             | ex::then([] { return 3; })
+                             | ex::bulk(N, [&] (int i, int factor) {
+                                 v[i] = factor*i;
+                               })
+                             | ex::then([&] (int factor) {
+                                 long s = 0;
+                                 for (auto e : v)
+                                   s += e;
+                                 return s/factor;
+                               })).value();
+  REQUIRE(sum == N*(N - 1)/2);
+}
+
+TEST_CASE("just values and errors", "[sender]") {
+  auto [a, b] = ex::sync_wait(ex::just(1, 2.5)).value();
+  REQUIRE(a == 1);
+  REQUIRE(b == 2.5);
+  queue q;
+  REQUIRE_THROWS_AS(ex::sync_wait(ex::schedule(q) | ex::then([] {
+      throw std::runtime_error { "failure" };
+    })), std::runtime_error);
+}
@@ -0,0 +1,75 @@
+/* RUN: %{execute}%s
+
+   Test the events returned by the command group submission
+*/
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <sycl/sycl.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace sycl;
+
+// To have access to handy C++14 units, like in 1ms
+using namespace std::literals;
+
+TEST_CASE("an event tracks the execution of its kernel", "[event]") {
+  queue q;
+  std::atomic<bool> go = false;
+  int v = 0;
+  buffer<int> b { &v, 1 };
+
+  auto e = q.submit([&] (handler &cgh) {
+      auto a = b.get_access<access::mode::write>(cgh);
+      cgh.single_task([=, &go] {
+          while (!go)
+            std::this_thread::sleep_for(1ms);
+          a[0] = 42;
+        });
+    });
+  REQUIRE(e.get_info<info::event::command_execution_status>()
+          != info::event_command_status::complete);
+  auto f = q.submit([&] (handler &cgh) {
+      auto a = b.get_access<access::mode::read_write>(cgh);
+      cgh.single_task([=] { ++a[0]; });
+    });
+  // The second kernel waits for the first one
+  auto wait_list = f.get_wait_list();
+  REQUIRE(wait_list.size() == 1);
+  REQUIRE(f.get_info<info::event::command_execution_status>()
+          == info::event_command_status::submitted);
+  // Profiling was not asked for
+  REQUIRE_THROWS_AS(e.get_profiling_info<info::event_profiling::command_end>(),
+                    invalid_object_error);
+  go = true;
+  event::wait({ e, f });
+  REQUIRE(e.get_info<info::event::command_execution_status>()
+          == info::event_command_status::complete);
+  REQUIRE(b.get_access<access::mode::read>()[0] == 43);
+}
+
+TEST_CASE("profiling records the kernel timestamps", "[event]") {
+  queue q { property::queue::enable_profiling {} };
+
+  auto e = q.submit([&] (handler &cgh) {
+      cgh.single_task([] { std::this_thread::sleep_for(10ms); });
+    });
+  // Waits for the kernel completion
+  auto end = e.get_profiling_info<info::event_profiling::command_end>();
+  auto start = e.get_profiling_info<info::event_profiling::command_start>();
+  auto submit = e.get_profiling_info<info::event_profiling::command_submit>();
+  REQUIRE(submit <= start);
+  REQUIRE(end - start >= 10'000'000);
+}
+
+TEST_CASE("a command group without kernel has a complete event",
+          "[event]") {
+  queue q;
+  auto e = q.submit([&] (handler &) {});
+  e.wait();
+  REQUIRE(e.get_info<info::event::command_execution_status>()
+          == info::event_command_status::complete);
+}